@@ -1,3 +1,9 @@
+-- premake5 --compact-cells vs2022, 16 bit cells for very large worlds, see app/include/cell.h
+newoption {
+    trigger     = "compact-cells",
+    description = "Pack cells into 16 bits instead of 32",
+}
+
 -- Defines solution
 workspace "falling-sand"
     architecture "x64"
@@ -66,3 +72,6 @@ project "app"
        runtime "Release"
        optimize "On"
        symbols "Off"
+
+   filter "options:compact-cells"
+       defines { "PIXEL_COMPACT_CELLS" }
@@ -0,0 +1,62 @@
+#pragma once
+#include "state.h"
+#include <memory>
+#include <vector>
+
+// Bump allocator for scratch that only lives for one Game::update(), reset at the start of the next one.
+// Allocating is a pointer bump, freeing is a no-op, reset() forgets everything at once.
+//
+// A frame that outgrows the current block chains another one on, reset() then swaps the chain for a
+// single block big enough for all of it. So only a frame that needs more scratch than any before it
+// touches the heap, a steady-state frame never does.
+class FrameArena {
+public:
+    void* allocate(size_t bytes, size_t align);
+    void  reset();
+
+    template <typename T>
+    T* allocate(size_t count) { // uninitialised, T has to be trivial
+        return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+    }
+
+    size_t used() const { return usedBytes; }
+    size_t capacity() const { return capacityBytes; }
+    size_t highWater() const { return highWaterBytes; } // most used in a single frame
+    u32    blockCount() const { return blocks.size(); }
+
+private:
+    static constexpr size_t MIN_BLOCK = 64 * 1024;
+
+    struct Block {
+        std::unique_ptr<u8[]> data;
+        size_t                size = 0;
+    };
+
+    std::vector<Block> blocks;
+    size_t             offset         = 0; // into blocks.back()
+    size_t             usedBytes      = 0; // this frame, alignment padding included
+    size_t             capacityBytes  = 0;
+    size_t             highWaterBytes = 0;
+};
+
+// Lets std containers live in a FrameArena. Memory is only handed back by FrameArena::reset(),
+// a container growing leaves its old buffer behind until then. Never keep one past the frame.
+template <typename T>
+struct ArenaAllocator {
+    using value_type = T;
+
+    FrameArena* arena;
+
+    ArenaAllocator(FrameArena& frameArena) : arena(&frameArena) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+
+    T*   allocate(size_t count) { return static_cast<T*>(arena->allocate(count * sizeof(T), alignof(T))); }
+    void deallocate(T*, size_t) {}
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const { return arena == other.arena; }
+};
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
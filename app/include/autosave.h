@@ -0,0 +1,54 @@
+#pragma once
+#include "cell.h"
+#include "snapshot.h"
+#include "state.h"
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <thread>
+
+// Periodic autosave that never makes the sim wait on the disk.
+// The world is split into CHUNK_SIZE x CHUNK_SIZE chunks, the texture writer reports every run of
+// cells it rewrites (i.e. every cell that changed) and the chunks they touch are marked dirty.
+// At a frame boundary capture() copies just the dirty chunks into a private mirror of the world,
+// that copy is the only stall, then a background thread encodes & writes the mirror while the sim carries on.
+class Autosave {
+public:
+    static constexpr u16 CHUNK_SIZE = 64;
+
+    ~Autosave() { wait(); }
+
+    void resize(u16 cellWidth, u16 cellHeight);
+    void markRun(u16 x, u16 y, u16 length) {
+        const u32 row = (y / CHUNK_SIZE) * chunkCols;
+        for (u32 cx = x / CHUNK_SIZE; cx <= static_cast<u32>(x + length - 1) / CHUNK_SIZE; cx++) dirty[row + cx] = true;
+    }
+    void markAll() { std::fill(dirty.begin(), dirty.end(), true); }
+
+    // Copies the dirty chunks of 'cells' into the mirror and starts writing it to 'path', along with the rest
+    // of the world once 'chunks' has it (see ChunkStore::collect()).
+    // Does nothing & returns false if the last save is still being written.
+    bool capture(const Cell* cells, const SnapshotHeader& header, const std::string& path, std::future<std::vector<StoredChunk>> chunks);
+    bool busy() const { return writing; }
+    void wait(); // blocks until the background write is done
+
+    f32 stallMs() const { return lastStallMs; }
+    f32 saveMs() const { return lastSaveMs; }
+    u32 chunksCopied() const { return lastChunksCopied; }
+    u32 chunkCount() const { return dirty.size(); }
+    u32 saveCount() const { return saves; }
+
+private:
+    u16 width = 0, height = 0;
+    u16 chunkCols = 0, chunkRows = 0;
+
+    std::vector<bool> dirty;  // chunks changed since their last capture
+    CellVector        mirror; // the world as of the last capture, only the writer reads it while it's running
+
+    std::thread       writer;
+    std::atomic<bool> writing          = false;
+    std::atomic<f32>  lastSaveMs       = 0;
+    f32               lastStallMs      = 0;
+    u32               lastChunksCopied = 0;
+    u32               saves            = 0;
+};
@@ -0,0 +1,6 @@
+#pragma once
+#include "state.h"
+
+// Headless benchmarks, no window or GL context needed.
+// Run with `app --benchmark [name]`, no name runs everything. Results are printed to stdout.
+int runBenchmarks(std::string_view filter);
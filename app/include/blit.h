@@ -0,0 +1,18 @@
+#pragma once
+#include "state.h"
+
+// Texel replication kernels, used by both texture writers.
+// Takes a row of packed RGBA cell colours (R in the lowest byte, same as the texture's byte order),
+// writes one horizontally replicated scanline, then memcpy's it down for the remaining scaleFactor - 1 rows.
+// scaleFactor 1, 2, 4 & 8 have dedicated SSE2 / AVX2 kernels, picked at runtime from cpuFeatures().
+//
+// dst points at the top left texel of the first cell, dstPitch is the texture's row length in bytes.
+void blitCellRow(const u32* colours, u32 count, u8 scaleFactor, u8* dst, u32 dstPitch);
+
+// Name of the kernel set in use, for the debug menu.
+std::string_view blitKernelName();
+
+// R | G | B | A --> one u32, in the same byte order the texture stores them.
+constexpr u32 packRGBA(u8 r, u8 g, u8 b, u8 a) {
+    return static_cast<u32>(r) | (static_cast<u32>(g) << 8) | (static_cast<u32>(b) << 16) | (static_cast<u32>(a) << 24);
+}
@@ -0,0 +1,217 @@
+#pragma once
+#include "state.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+
+// Span based brush rasterisers, templated on the sink so every span is a direct (inlinable) call.
+// Each shape emits horizontal runs as sink(x, y, length) in grid coords, centred on (cx, cy).
+// Runs are not clipped, wrap the sink with clipSpans() first if the shape can leave the grid.
+
+template <typename SpanSink>
+void rasterCircle(s32 cx, s32 cy, s32 size, SpanSink&& sink) {
+    // row tY covers every tX in [-size, size) with tX^2 + tY^2 <= size^2,
+    // halfWidth only ever moves by a little between rows so it's tracked instead of sqrt'd.
+    const s64 r2        = s64(size) * size;
+    s64       halfWidth = 0;
+    for (s32 tY = -size; tY < size; tY++) {
+        const s64 remaining = r2 - s64(tY) * tY;
+        while ((halfWidth + 1) * (halfWidth + 1) <= remaining) halfWidth++;
+        while (halfWidth * halfWidth > remaining) halfWidth--;
+
+        const s32 x0 = cx - static_cast<s32>(halfWidth);
+        const s32 x1 = cx + std::min(static_cast<s32>(halfWidth), size - 1); // inclusive
+        sink(x0, cy + tY, x1 - x0 + 1);
+    }
+}
+
+template <typename SpanSink>
+void rasterCircleOutline(s32 cx, s32 cy, s32 size, SpanSink&& sink) {
+    auto drawCircleSegments = [&](s32 x, s32 y) -> void {
+        sink(cx + x, cy + y, 1);
+        sink(cx - x, cy + y, 1);
+        sink(cx + x, cy - y, 1);
+        sink(cx - x, cy - y, 1);
+        sink(cx + y, cy + x, 1);
+        sink(cx - y, cy + x, 1);
+        sink(cx + y, cy - x, 1);
+        sink(cx - y, cy - x, 1);
+    };
+
+    s32 tX = 0;
+    s32 tY = size;
+    s32 d  = 3 - 2 * size;
+    drawCircleSegments(tX, tY);
+    while (tY >= tX) {
+        tX++;
+        if (d > 0) {
+            tY--;
+            d = d + 4 * (tX - tY) + 10;
+        } else d = d + 4 * tX + 6;
+        drawCircleSegments(tX, tY);
+    }
+}
+
+template <typename SpanSink>
+void rasterLine(s32 cx, s32 cy, s32 size, SpanSink&& sink) {
+    if (size > 0) sink(cx - size, cy, 2 * size);
+}
+
+template <typename SpanSink>
+void rasterSquare(s32 cx, s32 cy, s32 size, SpanSink&& sink) {
+    const s32 half = size / 2;
+    if (half == 0) return;
+    for (s32 tY = -half; tY < half; tY++) sink(cx - half, cy + tY, 2 * half);
+}
+
+template <typename SpanSink>
+void rasterSquareOutline(s32 cx, s32 cy, s32 size, SpanSink&& sink) {
+    // draws from centre, not top left.
+    const s32 half = size / 2;
+    sink(cx - half, cy - half, 2 * half + 1);
+    sink(cx - half, cy + half, 2 * half + 1);
+    for (s32 tY = -half; tY <= half; tY++) sink(cx - half, cy + tY, 1);
+    for (s32 tY = -half; tY <= half; tY++) sink(cx + half, cy + tY, 1);
+}
+
+template <typename SpanSink>
+void rasterShape(u8 shape, s32 cx, s32 cy, s32 size, SpanSink&& sink) {
+    switch (shape) {
+    case Shape::CIRCLE: rasterCircle(cx, cy, size, sink); break;
+    case Shape::CIRCLE_OUTLINE: rasterCircleOutline(cx, cy, size, sink); break;
+    case Shape::LINE: rasterLine(cx, cy, size, sink); break;
+    case Shape::SQUARE: rasterSquare(cx, cy, size, sink); break;
+    case Shape::SQUARE_OUTLINE: rasterSquareOutline(cx, cy, size, sink); break;
+    }
+}
+
+// Wraps a sink so it only ever sees the part of each run inside a width x height grid.
+template <typename SpanSink>
+auto clipSpans(s32 width, s32 height, SpanSink& sink) {
+    return [&sink, width, height](s32 x, s32 y, s32 length) -> void {
+        if (y < 0 || y >= height) return;
+        const s32 x0 = std::max(x, 0);
+        const s32 x1 = std::min(x + length, width);
+        if (x0 < x1) sink(x0, y, x1 - x0);
+    };
+}
+
+// Geometric-skip sampling for drawChance.
+// Rolling drawChance% per candidate cell costs one RNG call per cell, painted or not.
+// Instead this samples the gap to the next 'event', gap ~ Geometric(p), and skips straight to it.
+// Above 50% the events are the cells that *aren't* painted, so RNG work scales with min(p, 1 - p).
+// Same distribution as one roll per cell.
+class ChanceSampler {
+public:
+    explicit ChanceSampler(u8 drawChance) : drawChance(drawChance), invert(drawChance > 50) {
+        const f64 p = (invert ? 100 - drawChance : drawChance) / 100.0;
+        logMiss     = p > 0.0 ? std::log1p(-p) : 0.0;
+        if (p <= 0.0) return;
+
+        // inverse CDF lookup on the top 12 bits of the random number: gap = floor(ln(u) / ln(1 - p)), u in (0, 1].
+        // a bucket only gets an entry if every u inside it lands on the same gap, so the table is exact,
+        // buckets straddling a boundary fall back to the log.
+        for (u32 bucket = 1; bucket < BUCKETS; bucket++) {
+            const f64 minGap = std::log(f64(bucket + 1) / BUCKETS) / logMiss; // u at the top of the bucket
+            const f64 maxGap = std::log(f64(bucket) / BUCKETS) / logMiss;     // u at the bottom (exclusive)
+            if (maxGap < std::floor(minGap) + 1.0 - 1e-9 && minGap < AMBIGUOUS) table[bucket] = static_cast<u16>(minGap);
+        }
+    }
+
+    u8 chance() const { return drawChance; }
+
+    // number of candidates to skip before the next event, rand() returns a uniform u64.
+    template <typename Rng>
+    u64 nextGap(Rng&& rand) {
+        if (logMiss == 0.0) return UINT64_MAX; // 0% or 100%, no events ever.
+        const u64 r = rand();
+        if (table[r >> 52] != AMBIGUOUS) return table[r >> 52];
+        const f64 u = ((r >> 11) + 1) * 0x1.0p-53; // (0, 1], same top 12 bits as the bucket.
+        return static_cast<u64>(std::log(u) / logMiss);
+    }
+
+    // Picks cells out of a word of candidates, returns the ones that get painted.
+    // 'gap' carries over between words so runs can be fed in any number of pieces, start it with nextGap().
+    template <typename Rng>
+    u64 sampleBits(u64 candidates, u64& gap, Rng&& rand) {
+        const u64 original = candidates;
+        u64       events   = 0;
+        while (candidates) {
+            const u64 count = std::popcount(candidates);
+            if (gap >= count) {
+                gap -= count;
+                break;
+            }
+            for (u64 i = 0; i < gap; i++) candidates &= candidates - 1; // drop the skipped cells
+            events |= candidates & (~candidates + 1);
+            candidates &= candidates - 1;
+            gap = nextGap(rand);
+        }
+        return invert ? original & ~events : events;
+    }
+
+private:
+    static constexpr u32 BUCKETS   = 4096;
+    static constexpr u16 AMBIGUOUS = UINT16_MAX;
+
+    u8                       drawChance;
+    bool                     invert;  // events are misses, not paints
+    f64                      logMiss; // ln(1 - p) for the event probability p
+    std::array<u16, BUCKETS> table = filledTable();
+
+    static constexpr std::array<u16, BUCKETS> filledTable() {
+        std::array<u16, BUCKETS> t{};
+        t.fill(AMBIGUOUS);
+        return t;
+    }
+};
+
+// A brush shape rasterised once, relative to its centre, as run-length spans sorted by row.
+struct StampSpan {
+    s32 dx, dy, length;
+};
+
+struct BrushStamp {
+    u8                     shape    = Shape::COUNT;
+    u16                    size     = 0;
+    u64                    lastUsed = 0;
+    std::vector<StampSpan> spans;
+};
+
+// LRU cache of brush stamps keyed by (shape, size).
+// The same few shapes & sizes get stamped thousands of times a session, so stamping becomes
+// a copy of the cached spans offset to the cursor, clipped against the grid.
+class BrushCache {
+public:
+    // the reference is valid until the next get().
+    const BrushStamp& get(u8 shape, u16 size);
+
+    // Offsets a stamp's spans to (cx, cy), clips them to a width x height grid and passes them to sink(x, y, length).
+    template <typename SpanSink>
+    static void stamp(const BrushStamp& brush, s32 cx, s32 cy, s32 width, s32 height, SpanSink&& sink) {
+        // spans are sorted by row, so skip straight to the first visible one.
+        auto span = std::lower_bound(brush.spans.begin(), brush.spans.end(), -cy, [](const StampSpan& s, s32 dy) -> bool { return s.dy < dy; });
+        for (; span != brush.spans.end() && cy + span->dy < height; ++span) {
+            const s32 x0 = std::max(cx + span->dx, 0);
+            const s32 x1 = std::min(cx + span->dx + span->length, width);
+            if (x0 < x1) sink(x0, cy + span->dy, x1 - x0);
+        }
+    }
+
+    u32 hitCount() const { return hits; }
+    u32 missCount() const { return misses; }
+    u32 stampCount() const { return stamps.size(); }
+    u32 byteCount() const { return bytes; }
+
+private:
+    static constexpr u32 MAX_STAMPS = 16;
+    static constexpr u32 MAX_BYTES  = 4 * 1024 * 1024; // a size 10000 circle is ~240 KB
+
+    u64 tick   = 0;
+    u32 hits   = 0;
+    u32 misses = 0;
+    u32 bytes  = 0;
+
+    std::vector<BrushStamp> stamps;
+};
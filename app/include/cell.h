@@ -0,0 +1,138 @@
+#pragma once
+#include "memtrack.h"
+#include "snapshot.h"
+#include "state.h"
+#include <algorithm>
+#include <memory>
+
+// PIXEL_COMPACT_CELLS (premake5 --compact-cells) packs a cell into 16 bits instead of 32, for very large worlds.
+// Half the memory (and bandwidth), but every field access is a shift & mask, only 8 colour variants per
+// material and 7 bits of data. Snapshots record sizeof(Cell), so the two builds can't load each other's saves.
+#ifdef PIXEL_COMPACT_CELLS
+struct Cell {
+    u16 matID   : 5; // low bits on the compilers we build with, matchMaterial() checks before relying on it
+    u16 variant : 3; // index to array of randomly generated RGBA values from material's RGBA.
+    u16 updated : 1;
+    u16 data    : 7; // extra data if needed, e.g fire temp
+
+    constexpr Cell(bool UPDATED, u8 MATERIAL, u8 COLOUR_VARIANT, u8 EXTRA_DATA) : matID(MATERIAL), variant(COLOUR_VARIANT), updated(UPDATED), data(EXTRA_DATA) {}
+    Cell() = default;
+};
+constexpr u8 CELL_VARIANTS = 8;
+#else
+struct Cell {     // 32 bits of data, for more cache hits === speed.
+    bool updated; // uses 1 byte??? should just be a bit
+    u8   matID;
+    u8   variant; // index to array of randomly generated RGBA values from material's RGBA.
+    u8   data;    // extra data if needed, e.g fire temp
+
+    constexpr Cell(bool UPDATED, u8 MATERIAL, u8 COLOUR_VARIANT, u8 EXTRA_DATA) : updated(UPDATED), matID(MATERIAL), variant(COLOUR_VARIANT), data(EXTRA_DATA) {}
+    Cell() = default;
+};
+constexpr u8 CELL_VARIANTS = 20; // colour variants per material
+#endif
+static_assert(MaterialID::COUNT <= 32, "the compact cell has 5 bits of matID");
+
+struct Material {
+    bool                         movable;
+    u8                           r, g, b, a;
+    u8                           dispersion;
+    u16                          density;
+    std::vector<std::vector<u8>> variants;
+
+    Material(u8 RED, u8 GREEN, u8 BLUE, u8 ALPHA, u8 DISPERSION, u16 DENSITY, bool MOVABLE) {
+        r            = RED;
+        g            = GREEN;
+        b            = BLUE;
+        a            = ALPHA;
+        dispersion   = DISPERSION;
+        density      = DENSITY;
+        variants     = {{RED, GREEN, BLUE, ALPHA}};
+        movable      = MOVABLE;
+    }
+    Material() = default;
+};
+
+// Leaves new elements uninitialised on resize() instead of zeroing them. A 4K world is 32MB of cells, zeroing it
+// just before it gets filled (or copied over) doubles the cost, most of which is the OS faulting the pages in.
+template <typename T>
+struct DefaultInitAllocator : std::allocator<T> {
+    template <typename U>
+    struct rebind {
+        using other = DefaultInitAllocator<U>;
+    };
+    DefaultInitAllocator() = default;
+    template <typename U>
+    DefaultInitAllocator(const DefaultInitAllocator<U>&) noexcept {}
+
+    template <typename U, typename... Args>
+    void construct(U* p, Args&&... args) {
+        if constexpr (sizeof...(Args) == 0) ::new (static_cast<void*>(p)) U;
+        else ::new (static_cast<void*>(p)) U(std::forward<Args>(args)...);
+    }
+};
+using CellVector = std::vector<Cell, DefaultInitAllocator<Cell>>;
+
+// Backing store for the cell grid. Either owns its cells, or adopts a mapped snapshot and uses
+// the cell plane in place, the copy-on-write mapping means the sim can write to it like any other memory.
+class CellBuffer {
+public:
+    void resize(size_t count) {
+        MemoryScope tag(MemoryTag::CELLS);
+        mapped.close();
+        if (count > owned.capacity()) {
+            owned = CellVector();
+            owned.reserve(count);
+            adviseHugePages(owned.data(), count * sizeof(Cell)); // before resize(), which leaves the pages untouched
+        }
+        owned.resize(count);
+        cells  = owned.data();
+        nCells = count;
+    }
+
+    // like resize(), but keeps the cells that fit. Owned memory grows by half again whenever it runs out,
+    // so dragging the window edge reallocates every so often instead of every frame.
+    void resizeKeep(size_t count) {
+        MemoryScope tag(MemoryTag::CELLS);
+        detach();
+        if (count > owned.capacity()) owned.reserve(std::max(count, owned.capacity() + (owned.capacity() / 2)));
+        owned.resize(count);
+        cells  = owned.data();
+        nCells = count;
+    }
+
+    // takes over 'file', the cells start 'offset' bytes in.
+    void adopt(MappedFile&& file, size_t offset, size_t count) {
+        owned.clear();
+        owned.shrink_to_fit();
+        mapped = std::move(file);
+        cells  = reinterpret_cast<Cell*>(mapped.data() + offset);
+        nCells = count;
+    }
+
+    // copies mapped cells into owned memory, e.g. before the file under them is overwritten.
+    void detach() {
+        if (!isMapped()) return;
+        MemoryScope tag(MemoryTag::CELLS);
+        owned.assign(cells, cells + nCells);
+        mapped.close();
+        cells = owned.data();
+    }
+
+    bool               isMapped() const { return mapped.data() != nullptr; }
+    const std::string& mappedPath() const { return mapped.path(); }
+
+    Cell&       operator[](size_t i) { return cells[i]; }
+    const Cell& operator[](size_t i) const { return cells[i]; }
+    Cell*       data() { return cells; }
+    const Cell* data() const { return cells; }
+    Cell*       begin() { return cells; }
+    Cell*       end() { return cells + nCells; }
+    size_t      size() const { return nCells; }
+
+private:
+    Cell*             cells  = nullptr;
+    size_t            nCells = 0;
+    CellVector        owned;
+    MappedFile        mapped;
+};
@@ -0,0 +1,85 @@
+#pragma once
+#include "cell.h"
+#include "dirty.h"
+#include "memtrack.h"
+#include "state.h"
+#include <algorithm>
+
+// Which CHUNK_SIZE x CHUNK_SIZE chunks of the world are a single material, and which.
+// The sim skips chunks of a material that never does anything (see Game::updateRow()), a full
+// texture redraw fills single coloured ones without looking at their cells.
+//
+// Inside the window this saves work, not memory: the cells stay in the flat grid, everything
+// from the blitter to mapped snapshots indexes it directly, so a uniform chunk there still has
+// all of its cells. Only outside the window is a uniform chunk kept as just its material, see
+// ChunkStore::storeUniform().
+//
+// A chunk is only rechecked when something in it changed: chunks are one DirtyBitmap tile wide,
+// so the tiles marked since the last texture write say which ones to look at.
+class ChunkMap {
+public:
+    static constexpr u16 CHUNK_SIZE = 64; // == a DirtyBitmap tile
+    static constexpr u8  MIXED      = 0xFF;
+
+    // sizes the map to the grid & checks every chunk.
+    void rebuild(const Cell* cells, u16 cellWidth, u16 cellHeight) {
+        MemoryScope tag(MemoryTag::CHUNKS);
+        width  = cellWidth;
+        height = cellHeight;
+        cols   = (width + CHUNK_SIZE - 1) / CHUNK_SIZE;
+        rows   = (height + CHUNK_SIZE - 1) / CHUNK_SIZE;
+        materials.resize(static_cast<size_t>(cols) * rows);
+        checkedAt.assign(materials.size(), 0);
+        uniform = 0;
+        for (u16 cy = 0; cy < rows; cy++)
+            for (u16 cx = 0; cx < cols; cx++) {
+                materials[(cy * cols) + cx] = check(cells, cx, cy);
+                uniform += materials[(cy * cols) + cx] != MIXED;
+            }
+    }
+
+    // rechecks the chunks with a marked tile, each once.
+    void refresh(const Cell* cells, const DirtyBitmap& changed) {
+        pass++;
+        changed.forEachTile([&](u16 x, u16 y) -> void {
+            const u32 chunk = ((y / CHUNK_SIZE) * cols) + (x / CHUNK_SIZE);
+            if (checkedAt[chunk] == pass) return;
+            checkedAt[chunk] = pass;
+
+            const u8 material = check(cells, x / CHUNK_SIZE, y / CHUNK_SIZE);
+            uniform += (material != MIXED) - (materials[chunk] != MIXED);
+            materials[chunk] = material;
+        });
+    }
+
+    u8  material(u16 cx, u16 cy) const { return materials[(cy * cols) + cx]; } // MIXED, or the chunk's only material
+    u16 colCount() const { return cols; }
+    u16 rowCount() const { return rows; }
+    u32 uniformCount() const { return uniform; }
+    u32 chunkCount() const { return materials.size(); }
+
+private:
+    // the chunk's material if every cell in it is the same one. The first differing row ends it,
+    // a row is OR'd together whole so the compiler can vectorise it.
+    u8 check(const Cell* cells, u16 cx, u16 cy) const {
+        const u32 x0       = cx * CHUNK_SIZE;
+        const u32 x1       = std::min<u32>(x0 + CHUNK_SIZE, width);
+        const u32 y1       = std::min<u32>((cy + 1) * CHUNK_SIZE, height);
+        const u8  material = cells[(cy * CHUNK_SIZE * width) + x0].matID;
+        for (u32 y = cy * CHUNK_SIZE; y < y1; y++) {
+            const Cell* row  = &cells[y * width];
+            u32         diff = 0;
+            for (u32 x = x0; x < x1; x++) diff |= row[x].matID ^ material;
+            if (diff) return MIXED;
+        }
+        return material;
+    }
+
+    u16 width = 0, height = 0;
+    u16 cols = 0, rows = 0;
+    u32 uniform = 0;
+    u32 pass    = 0; // refresh() count, checkedAt[chunk] == pass once it's been looked at this time
+
+    std::vector<u8>  materials;
+    std::vector<u32> checkedAt;
+};
@@ -0,0 +1,119 @@
+#pragma once
+#include "cell.h"
+#include "memtrack.h"
+#include "state.h"
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <iosfwd>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+// The world outside the window Game simulates, see Game::streamWorld() & Game::moveWindow().
+// Chunks are keyed by their chunk coordinates in the world. One that was never stored has never been
+// visited, it's all EMPTY and doesn't exist anywhere yet.
+//
+// A chunk that's all one material is kept as just that material, no cells & no slot in the file, see
+// storeUniform(). It's only expanded back into cells once something's written into it, see store().
+//
+// Stored chunks are kept resident in an LRU cache. Once that's over budget the least recently used ones
+// are evicted to the chunk store file, one fixed size slot per chunk. All of the file I/O happens on one
+// background thread, in the order it was asked for, so a read queued after a write of the same chunk
+// gets what was written. Chunks are asked for ahead of time with request() & arrive in a later poll(),
+// nothing here ever waits on the disk. Snapshots take every chunk with them, see collect().
+class ChunkStore {
+public:
+    static constexpr u16 CHUNK_SIZE  = 64; // == ChunkMap::CHUNK_SIZE
+    static constexpr u32 CHUNK_CELLS = CHUNK_SIZE * CHUNK_SIZE;
+    static constexpr u32 CHUNK_BYTES = CHUNK_CELLS * sizeof(Cell);
+
+    ~ChunkStore();
+
+    void open(const std::string& path); // the file is only created once the first chunk gets evicted
+    void clear();                       // forgets every chunk, the file is emptied in the background
+    void setBudget(u64 bytes) { budget = bytes; }
+    bool isOpen() const { return !filePath.empty(); }
+
+    bool known(s32 cx, s32 cy) const { return resident.contains(key(cx, cy)) || slots.contains(key(cx, cy)) || uniforms.contains(key(cx, cy)); } // stored at some point
+    bool ready(s32 cx, s32 cy) const { return resident.contains(key(cx, cy)) || !slots.contains(key(cx, cy)); } // find() / uniform() has it, or it's never been stored
+    void request(s32 cx, s32 cy); // starts loading a known chunk that isn't resident, counts as a use if it is
+
+    Cell* find(s32 cx, s32 cy);                         // the resident chunk, or nullptr
+    bool  uniform(s32 cx, s32 cy, u8& material) const; // true if the chunk is all 'material' & has no cells
+    Cell* store(s32 cx, s32 cy, bool& created);         // resident chunk to write to, uninitialised if it was just created or expanded
+    void  storeUniform(s32 cx, s32 cy, u8 material);    // the chunk's all 'material' now, its cells & slot are dropped
+    void  release(s32 cx, s32 cy);                      // drops the resident copy without writing it back, the caller has the cells now
+    void  pin(s32 cx, s32 cy, bool pinned);             // pinned chunks are never evicted
+    void  poll();                                       // takes in the reads that finished, then evicts down to the budget
+
+    // Every stored chunk as it is now, RLE encoded for a snapshot. Resident chunks newer than the file are copied
+    // here & now, the rest is read back & everything's encoded on the I/O thread, in order with the other jobs.
+    // So the future's only ready once the writes queued before it are done, whoever saves waits on it, not the sim.
+    std::future<std::vector<StoredChunk>> collect(u8 nVariants);
+
+    u32 residentCount() const { return resident.size(); }
+    u64 residentBytes() const { return static_cast<u64>(resident.size()) * CHUNK_BYTES; }
+    u32 uniformCount() const { return uniforms.size(); }
+    u32 storedCount() const { return slots.size(); }
+    u32 loadingCount() const { return requested.size(); }
+    u32 readCount() const { return reads; }
+    u32 writeCount() const { return writes; }
+
+private:
+    struct Collection {
+        std::vector<StoredChunk>                              chunks; // the uniform ones go straight in
+        std::vector<std::pair<u64, std::unique_ptr<Cell[]>>> copied; // resident chunks newer than their slot
+        std::vector<std::pair<u64, u32>>                      slots;  // chunk --> slot, read back on the I/O thread
+        std::promise<std::vector<StoredChunk>>                promise;
+        u8                                                    nVariants = 0;
+    };
+    struct Job {
+        enum : u8 { READ, WRITE, TRUNCATE, COLLECT };
+        u8                          op;
+        u64                         chunk;
+        u32                         slot;
+        u32                         generation;
+        std::unique_ptr<Cell[]>     cells;      // what to write / what was read, nullptr once it's failed
+        std::unique_ptr<Collection> collection; // COLLECT only
+    };
+    struct Entry {
+        std::unique_ptr<Cell[]>  cells;
+        std::list<u64>::iterator use;
+        bool                     dirty  = false; // newer than its slot in the file
+        bool                     pinned = false;
+    };
+
+    static u64 key(s32 cx, s32 cy) { return (static_cast<u64>(static_cast<u32>(cx)) << 32) | static_cast<u32>(cy); }
+
+    Entry& insert(u64 chunk, std::unique_ptr<Cell[]> cells);
+    void   evict(u64 chunk);
+    void   queue(Job&& job); // starts the I/O thread on first use
+    void   work();
+    void   finishCollect(Collection& collection, std::fstream& file); // on the I/O thread
+
+    std::string filePath;
+    u64         budget     = 64 * 1024 * 1024;
+    u32         generation = 0; // clear() count, reads queued before the last clear() are thrown away
+    u32         reads      = 0;
+    u32         writes     = 0;
+
+    std::unordered_map<u64, Entry> resident;
+    std::list<u64>                 uses;      // resident chunks, most recently used first
+    std::unordered_map<u64, u32>   slots;     // chunk --> its slot in the file, given out on its first eviction
+    std::unordered_map<u64, u8>    uniforms;  // chunk --> its only material, for chunks with no cells
+    std::unordered_set<u64>        requested; // reads in flight
+    std::vector<u32>               freeSlots; // given up by chunks that went uniform, handed out again before nextSlot
+    u32                            nextSlot = 0;
+
+    // shared with the I/O thread
+    std::thread             worker;
+    std::mutex              lock;
+    std::condition_variable wake;
+    std::deque<Job>         jobs;
+    std::vector<Job>        done; // finished reads & failed writes
+    bool                    stopping = false;
+};
@@ -0,0 +1,162 @@
+#pragma once
+#include "memtrack.h"
+#include "state.h"
+#include <algorithm>
+#include <bit>
+
+// Per-cell dirty bitmap, tracks which cells need their texels rewritten this frame.
+// Marking a cell twice in a frame costs a bit test instead of a second texture write.
+// Also doubles as the coverage mask for brush strokes, see Game::mouseDraw().
+//
+// Each row is padded to a whole number of u64 words, one word == one 'tile' of 64 cells.
+// The first mark in a tile appends it to 'tiles', so a quiet frame never scans the whole bitmap.
+class DirtyBitmap {
+public:
+    void resize(u16 width, u16 height) {
+        MemoryScope tag(MemoryTag::CHANGE_LISTS);
+        stride = (width + 63) / 64;
+        bits.assign(static_cast<size_t>(stride) * height, 0);
+        tiles.clear();
+        tiles.reserve(bits.size()); // every word at most once, so mark() never has to allocate
+        marks = 0;
+        cells = 0;
+    }
+
+    // like resize(), but keeps the marks. The grid can only have grown, rows are moved to the new stride last row first.
+    void grow(u16 width, u16 height) {
+        const u32 newStride = (width + 63) / 64;
+        const u32 oldRows   = stride ? bits.size() / stride : 0;
+        MemoryScope tag(MemoryTag::CHANGE_LISTS);
+        bits.resize(static_cast<size_t>(newStride) * height, 0);
+        tiles.reserve(bits.size());
+        if (newStride == stride) return;
+
+        for (u32 y = oldRows; y-- > 0;) {
+            std::copy_backward(bits.begin() + (y * stride), bits.begin() + ((y + 1) * stride), bits.begin() + (y * newStride) + stride);
+            std::fill(bits.begin() + (y * newStride) + stride, bits.begin() + ((y + 1) * newStride), 0);
+        }
+        for (u32& word : tiles) word = ((word / stride) * newStride) + (word % stride);
+        stride = newStride;
+    }
+
+    // returns false if the cell was already marked.
+    bool mark(u16 x, u16 y) {
+        const u32 word = (y * stride) + (x >> 6);
+        const u64 bit  = u64(1) << (x & 63);
+        marks++;
+        if (bits[word] & bit) return false; // already queued this frame, the duplicate we're here to skip.
+        if (bits[word] == 0) tiles.push_back(word);
+        bits[word] |= bit;
+        cells++;
+        return true;
+    }
+
+    // Marks a whole horizontal run a word at a time. Calls fresh(baseX, y, bits) for each word with
+    // newly marked cells, bit i of 'bits' being cell baseX + i. Cells that were already marked are left out.
+    template <typename Func>
+    void markRun(u16 x, u16 y, u16 length, Func&& fresh) {
+        u32 word = (y * stride) + (x >> 6);
+        u16 bit  = x & 63;
+        while (length) {
+            const u16 count   = std::min<u16>(64 - bit, length);
+            const u64 mask    = (count == 64 ? ~u64(0) : ((u64(1) << count) - 1)) << bit;
+            const u64 newBits = mask & ~bits[word];
+            marks += count;
+            if (newBits) {
+                if (bits[word] == 0) tiles.push_back(word);
+                bits[word] |= newBits;
+                cells += std::popcount(newBits);
+                fresh(static_cast<u16>(x - bit), y, newBits);
+            }
+            x += count;
+            length -= count;
+            bit = 0;
+            word++;
+        }
+    }
+
+    // marks bit i of 'newBits' as cell x + i, x must be a multiple of 64.
+    void markBits(u16 x, u16 y, u64 newBits) {
+        const u32 word = (y * stride) + (x >> 6);
+        marks += std::popcount(newBits);
+        newBits &= ~bits[word];
+        if (!newBits) return;
+        if (bits[word] == 0) tiles.push_back(word);
+        bits[word] |= newBits;
+        cells += std::popcount(newBits);
+    }
+
+    void markRun(u16 x, u16 y, u16 length) {
+        markRun(x, y, length, [](u16, u16, u64) -> void {});
+    }
+
+    bool test(u16 x, u16 y) const { return bits[(y * stride) + (x >> 6)] & (u64(1) << (x & 63)); }
+    u64  word(u16 x, u16 y) const { return bits[(y * stride) + (x >> 6)]; } // the 64 cells starting at x & ~63
+
+    void clear() {
+        for (u32 word : tiles) bits[word] = 0;
+        tiles.clear();
+        marks = 0;
+        cells = 0;
+    }
+
+    u32 markCount() const { return marks; } // every mark() call, duplicates included
+    u32 cellCount() const { return cells; } // unique cells, == texture writes performed
+    u32 tileCount() const { return tiles.size(); }
+
+    // Calls foo(x, y) for each tile with a mark in it, x being its first cell. Doesn't clear anything.
+    template <typename Func>
+    void forEachTile(Func&& foo) const {
+        for (u32 word : tiles) foo(static_cast<u16>((word % stride) * 64), static_cast<u16>(word / stride));
+    }
+
+    // Calls foo(x, y, length) for each horizontal run of dirty cells, in memory order, then clears.
+    // Runs that cross a tile boundary are joined, so the texture writer gets the longest runs possible.
+    template <typename Func>
+    void forEachRun(Func&& foo) {
+        // sorting a handful of tiles is cheaper than a full scan, a full scan is cheaper than sorting most of them.
+        const bool fullScan = tiles.size() * 8 > bits.size();
+        if (!fullScan) std::sort(tiles.begin(), tiles.end());
+
+        u16  runX = 0, runY = 0, runLength = 0;
+        auto visitWord = [&](u32 word) -> void {
+            u64       w     = bits[word];
+            const u16 y     = word / stride;
+            const u16 baseX = (word % stride) * 64;
+            bits[word]      = 0;
+            while (w) {
+                const u16 start  = std::countr_zero(w);
+                const u16 length = std::countr_one(w >> start);
+                const u16 x      = baseX + start;
+                if (runLength && runY == y && runX + runLength == x) runLength += length;
+                else {
+                    if (runLength) foo(runX, runY, runLength);
+                    runX      = x;
+                    runY      = y;
+                    runLength = length;
+                }
+                w = (length + start == 64) ? 0 : w & ~(((u64(1) << length) - 1) << start);
+            }
+        };
+
+        if (fullScan) {
+            for (u32 word = 0; word < bits.size(); word++)
+                if (bits[word]) visitWord(word);
+        } else {
+            for (u32 word : tiles) visitWord(word);
+        }
+        if (runLength) foo(runX, runY, runLength);
+
+        tiles.clear();
+        marks = 0;
+        cells = 0;
+    }
+
+private:
+    u32 stride = 0; // words per row
+    u32 marks  = 0;
+    u32 cells  = 0;
+
+    std::vector<u64> bits;
+    std::vector<u32> tiles; // words that went 0 --> non-zero since the last clear
+};
@@ -1,5 +1,6 @@
 #pragma once
 #include "game.h"
+#include "inputlog.h"
 #include "interface.h"
 #include "state.h"
 #include <SDL.h>
@@ -18,17 +19,24 @@ public:
     inline bool running() const { return applicationRunning; } // const means this function cannot modify any member variables
 
 private:
-    void loadImageRGB(TextureData& texture, std::string path);
-    void loadImageRGBA(TextureData& texture, std::string path); // png is somehow rgb not rgba..
+    bool loadImageRGB(TextureData& texture, std::string path);
+    bool loadImageRGBA(TextureData& texture, std::string path); // keeps the alpha channel
 
-    void saveToFile(TextureData& texture);
-    void loadFromFile(TextureData& texture, std::string path);
+    void saveToFile(const std::string& path);
+    void loadFromFile(const std::string& path);
+
+    void recordInputs(const std::string& path);
+    void replayInputs(const std::string& path);
+    void replayFrame(TextureData& texture);
 
     void createTexture(TextureData& texture);
     void updateTexture(TextureData& texture);
+    void updateTexture(TextureData& texture, const TexRect& rect);
+    void resizeTexture(TextureData& texture);
     void reloadTextures();
 
     void mouseDraw();
+    void logStage(u8 message);
 
     /*----------------------------------------------------------------
    ---- Variables ---------------------------------------------------
@@ -37,7 +45,12 @@ private:
 
     bool applicationRunning = false;
 
+    std::chrono::steady_clock::time_point startupStart; // when init() started
+    std::chrono::steady_clock::time_point stageStart;   // when the last startup stage finished
+    u64                                   frameAllocations = 0; // heapAllocations() at the start of the last update()
+
     AppState      state;                // consolidated shared state into a structure.
+    InputLog      inputLog;
     Game*         game       = nullptr; // std::unique_ptr<Game>
     Interface*    interface  = nullptr; // std::unique_ptr<Interface>
     SDL_Window*   window     = nullptr; // could use a unique ptr but would require a refactor,
@@ -1,41 +1,17 @@
 #pragma once
+#include "arena.h"
+#include "autosave.h"
+#include "brush.h"
+#include "cell.h"
+#include "chunkmap.h"
+#include "chunkstore.h"
+#include "dirty.h"
+#include "memtrack.h"
+#include "regions.h"
+#include "rewind.h"
+#include "snapshot.h"
 #include "state.h"
-#include <functional>
-
-struct Cell {     // 32 bits of data, for more cache hits === speed.
-    bool updated; // uses 1 byte??? should just be a bit
-    u8   matID;
-    u8   variant; // index to array of randomly generated RGBA values from material's RGBA.
-    u8   data;    // extra data if needed, e.g fire temp
-
-    Cell(bool UPDATED, u8 MATERIAL, u8 COLOUR_VARIANT, u8 EXTRA_DATA) {
-        updated = UPDATED;
-        matID   = MATERIAL;
-        variant = COLOUR_VARIANT;
-        data    = EXTRA_DATA;
-    }
-    Cell() = default;
-};
-
-struct Material {
-    bool                         movable;
-    u8                           r, g, b, a;
-    u8                           dispersion;
-    u16                          density;
-    std::vector<std::vector<u8>> variants;
-
-    Material(u8 RED, u8 GREEN, u8 BLUE, u8 ALPHA, u8 DISPERSION, u16 DENSITY, bool MOVABLE) {
-        r            = RED;
-        g            = GREEN;
-        b            = BLUE;
-        a            = ALPHA;
-        dispersion   = DISPERSION;
-        density      = DENSITY;
-        variants     = {{RED, GREEN, BLUE, ALPHA}};
-        bool movable = MOVABLE;
-    }
-    Material() = default;
-};
+#include <chrono>
 
 class Game {
 public:
@@ -47,9 +23,17 @@ public:
     void update(AppState& state, std::vector<u8>& textureData);
     void reset();
 
-    void loadImage(std::vector<u8>& textureData, std::vector<u8>& imageTextureData, u16 imageWidth, u16 imageHeight);
+    void loadImage(const std::vector<u8>& image, u16 imageWidth, u16 imageHeight); // RGBA
+
+    void mouseDraw(u16 x, u16 y, u16 size, u8 drawChance, u8 material, u8 shape); // texel coords, through the camera
+    void drawAt(u16 x, u16 y, u16 size, u8 drawChance, u8 material, u8 shape);    // cell coords
+    std::pair<u16, u16> cellAt(u16 mx, u16 my) const; // texel --> cell under it, off the grid if no cell's drawn there
+    bool                loadingWindow() const { return !arriving.empty(); } // a resize uncovered chunks that are still being read in
+    bool                resizeUsedStore() const { return resizeLoaded; }    // the last reload() uncovered chunks from the store, in or not
+    void endStroke();
 
-    void mouseDraw(u16 x, u16 y, u16 size, u8 drawChance, u8 material, u8 shape);
+    bool saveSnapshot(const std::string& path, u32 frame, u8 encoding = SnapshotEncoding::RAW);
+    bool loadSnapshot(const std::string& path, u32& frame);
 
 private:
     void simulate(AppState& state);
@@ -58,31 +42,62 @@ private:
     void r_bottomUpUpdate();
     void snakeUpdate();
     void golUpdate();
+    void updateRow(u16 y, bool leftToRight);
 
     void changeMaterial(u16 x, u16 y, u8 newMaterial);
     void swapCells(u16 x1, u16 y1, u16 x2, u16 y2);
     bool querySwap(u16 x1, u16 y1, u16 x2, u16 y2);
     bool querySwapAbove(u16 x1, u16 y1, u16 x2, u16 y2);
 
-    bool updateCell(u16 x, u16 y);
+    static bool inert(u8 matID) { return matID == MaterialID::EMPTY || matID == MaterialID::CONCRETE; } // updateCell() leaves these be
+    bool        updateCell(u16 x, u16 y);
+    s8          dispersion(u8 factor) const { return std::min<s32>(factor * dispersionScale, INT8_MAX); } // moves per update
     bool updateSand(u16 x, u16 y);
     bool updateWater(u16 x, u16 y);
     bool updateNaturalGas(u16 x, u16 y);
 
     void updateTextureData(std::vector<u8>& textureData);
     void updateEntireTextureData(std::vector<u8>& textureData);
+    void updateGrownTextureData(std::vector<u8>& textureData);
+    void drawView(std::vector<u8>& textureData);
+    void clearTextureBorder(std::vector<u8>& textureData);
+    void buildPalette();
+    void buildColourLUT();
+
+    u64            materialHash() const;
+    SnapshotHeader snapshotHeader(u32 frame, u8 encoding) const;
+    void           releaseMapping(const std::string& path);
+
+    void seekHistory(AppState& state);
+
+    void       streamWorld(AppState& state);
+    bool       requestChunks(s32 x, s32 y);
+    void       storeChunks(s32 x, s32 y, u16 width, u16 height);
+    void       storeChunk(s32 cx, s32 cy, const Cell* src, u32 pitch, u16 w, u16 h);
+    bool       loadChunks(s32 x, s32 y, u16 width, u16 height);
+    void       copyChunk(s32 cx, s32 cy);
+    void       moveWindow(s32 x, s32 y);
+    static u16 visibleCells(s32 chunk, s32 origin, u16 length);
+
+    void applyCamera(AppState& state);
+    u16  viewCols() const { return std::clamp<s32>(cellWidth - viewX, 0, textureWidth / zoom); } // whole cells on screen
+    u16  viewRows() const { return std::clamp<s32>(cellHeight - viewY, 0, textureHeight / zoom); }
+
+    void fillEmpty(Cell* first, u32 count);
+    void fillMaterial(Cell* first, u32 count, u8 material);
+    bool uniformChunk(const Cell* chunk, u8& material) const;
+    void paintRun(u16 x, u16 y, u16 length, u8 material, u64& gap);
+    void floodFill(u16 x, u16 y, u8 material);
+    void createDrawIndicators(u16 x, u16 y, u16 size, u8 shape, std::vector<std::pair<u16, u16>>& indicators);
 
-    void createDrawIndicators(u16 x, u16 y, u16 size, u8 shape);
-
-    void drawCircle(u16 x, u16 y, u16 size, u8 material, u8 drawChance, std::function<void(u16, u16, u8)> foo);
-    void drawCircleOutline(u16 x, u16 y, u16 size, u8 material, u8 drawChance, std::function<void(u16, u16, u8)> foo);
-    void drawLine(u16 x, u16 y, u16 size, u8 material, u8 drawChance, std::function<void(u16, u16, u8)> foo);
-    void drawSquare(u16 x, u16 y, u16 size, u8 material, u8 drawChance, std::function<void(u16, u16, u8)> foo);
-    void drawSquareOutline(u16 x, u16 y, u16 size, u8 material, u8 drawChance, std::function<void(u16, u16, u8)> foo);
 
     bool outOfBounds(u16 x, u16 y) const { return x >= cellWidth || y >= cellHeight || x < 0 || y < 0; }
     u32  cellIdx(u16 x, u16 y) const { return (y * cellWidth) + x; }
+    void recordChange(u32 idx) { // call before writing to a cell, keeps its old value for rewinding.
+        if (rewind.recording()) rewind.record(idx, cells[idx]);
+    }
     u32  textureIdx(u16 x, u16 y) const { return 4 * ((y * textureWidth) + x); }
+    u32  paletteIdx(const Cell& c) const { return (c.matID * nVariants) + c.variant; }
 
     template <typename T> // cheeky template
     inline T getRand(T min = -1, T max = 1) {
@@ -102,10 +117,28 @@ private:
 
 
     bool sizeChanged = false;
+    bool viewChanged = false; // the camera moved, the whole view is redrawn but the grid's the same
+    bool resetCamera = false; // init() / a new scaleFactor put the camera back, AppState follows on the next update()
+    bool grown       = false; // reload() only added cells to the right / bottom, see updateGrownTextureData()
+    bool rewindStale = true; // the world changed under the rewind history, restart it next update()
+    bool windowMoved = false; // moveWindow() shifted the sim schedule along with the grid, it doesn't need rebuilding
+    bool skipUniform = true; // skip chunks the ChunkMap says are inert, see updateRow()
+
+    // last stamp of the current brush stroke, the next one interpolates from here.
+    bool strokeActive = false;
+    u16  strokeX      = 0;
+    u16  strokeY      = 0;
+
+    // brush outline is only rebuilt when the mouse cell, size or shape changes.
+    u16 indicatorX     = UINT16_MAX;
+    u16 indicatorY     = UINT16_MAX;
+    u16 indicatorSize  = 0;
+    u8  indicatorShape = Shape::COUNT;
 
     u8 gasDispersionFactor;
     u8 fluidDispersionFactor;
     u8 solidDispersionFactor;
+    u8 dispersionScale = 1; // chunks stepped every n frames move n times as far, see RegionScheduler
 
     u8  nVariants;
     u8  scaleFactor;
@@ -113,8 +146,39 @@ private:
     u16 cellWidth, cellHeight;
     u64 seed = 1234567890987654321;
 
-    std::vector<Cell>                cells;
+    // the camera, the part of the grid that's drawn into the texture. zoom is texels per cell, scaleFactor
+    // only decides how big the grid is. Starts out showing all of it, at scaleFactor.
+    s32 viewX = 0, viewY = 0; // top left cell on screen
+    u8  zoom  = 1;
+
+    s32 worldX = 0, worldY = 0; // chunk the window's top left corner is in
+    s32 panX = 0, panY = 0;     // where the window's headed, see streamWorld()
+
+    std::vector<std::pair<s32, s32>> arriving;             // chunks in the window still being read in, see loadChunks()
+    bool                             resizeLoaded = false; // see resizeUsedStore()
+
+    struct {
+        u16 viewCols, viewRows, textureWidth, textureHeight;
+    } grownFrom{}; // size before the first reload() since the texture was last written
+
+    CellBuffer                       cells;
     std::vector<Material>            materials;
-    std::vector<std::pair<u16, u16>> textureChanges;
-    std::vector<std::pair<u16, u16>> drawIndicators;
+    std::vector<u32>                 palette;    // packed RGBA per (matID, variant), flattened copy of materials[].variants
+    std::vector<Cell>                colourLUT;  // RGB bucket --> cell of the nearest palette colour, built on first import
+    std::vector<Cell>                emptyCells; // EMPTY cells in random variants that fillEmpty() copies runs out of
+    std::array<bool, MaterialID::COUNT> flatMaterials{}; // drawn as one colour, see buildPalette()
+    std::vector<TexRect>             textureUploads; // parts of the texture written this update()
+    DirtyBitmap                      textureChanges; // cells whose texels need rewriting
+    DirtyBitmap                      strokeCoverage; // cells the current brush stroke has already covered
+    ChunkMap                         chunks;         // which chunks are all one material
+    RegionScheduler                  regions;        // which chunks the sim steps this frame
+    ChunkStore                       world;          // every chunk outside the window
+    ChanceSampler                    chanceSampler{100}; // rebuilt whenever drawChance changes
+    BrushCache                       brushCache;
+    Autosave                         autosave;
+    RewindBuffer                     rewind;
+    FrameArena                       frameArena; // scratch for the current update(), see arena.h
+
+    std::chrono::steady_clock::time_point lastAutosave; // when the last autosave was captured
+    std::vector<std::pair<u16, u16>> fillStack; // pending seeds for floodFill()
 };
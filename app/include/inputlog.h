@@ -0,0 +1,102 @@
+#pragma once
+#include "snapshot.h"
+#include "state.h"
+#include <fstream>
+
+// Ops in an input log, each followed by its payload. Varints are LEB128, see putVarint().
+struct InputOp {
+    enum : u8 {
+        TICKS,      // varint n: the next n frames (Game::update() calls) had no other input
+        DRAW,       // zigzag varint dx, dy from the last DRAW: mouse held at texel (x, y) of the camera at rest, i.e. cell (x, y) / scaleFactor
+        END_STROKE, // mouse released
+        BRUSH,      // varint drawSize, u8 drawChance, drawMaterial, drawShape
+        SIM,        // u8 runSim, scanMode, fluidDispersionFactor, solidDispersionFactor
+        RESET,
+        RELOAD,     // varint textureWidth, textureHeight, u8 scaleFactor
+        COUNT,
+    };
+};
+
+// What the caller has to do, the brush & sim settings are applied to the AppState by next() itself.
+struct InputEvent {
+    u8  op = InputOp::COUNT; // TICKS == run one Game::update()
+    u16 x = 0, y = 0;        // DRAW: mouse position, RELOAD: texture size
+    u8  scaleFactor = 0;     // RELOAD
+};
+
+// Records every input that changes the world, so a session can be played back exactly.
+//
+// A log is an RLE snapshot of the world when recording started, followed by the inputs.
+// The snapshot loader stops at the end of the cell plane, so a log loads like any other save,
+// and brings the seed & frame back with it. The sim only ever draws from that seed, so the same
+// inputs on the same frames reproduce the same world cell for cell.
+class InputLog {
+public:
+    ~InputLog() { stop(); }
+
+    // the world has to be saved first, see Game::saveSnapshot(), the inputs are appended to it.
+    bool record(const std::string& path, const AppState& state);
+    bool replay(const std::string& path, SnapshotHeader& header); // the caller sizes & loads the world from the header
+    void stop();
+
+    u8  mode() const { return current; }
+    u32 tickCount() const { return ticks; }
+    u32 length() const { return totalTicks; } // replay only
+    u32 byteCount() const { return bytes + buffer.size(); }
+
+    // recording, call in the order the inputs are applied.
+    void settings(const AppState& state); // logs the brush & sim settings that changed since the last frame
+    void draw(u16 x, u16 y);
+    void endStroke();
+    void reset();
+    void reload(u16 textureWidth, u16 textureHeight, u8 scaleFactor);
+    void tick(const AppState& state); // after Game::update()
+
+    // replaying, returns false at the end of the log.
+    bool next(AppState& state, InputEvent& event);
+
+private:
+    struct Brush {
+        u16  size;
+        u8   chance, material, shape;
+        bool operator==(const Brush&) const = default;
+    };
+    struct Sim {
+        u8   runSim, scanMode, fluidDispersion, solidDispersion;
+        bool operator==(const Sim&) const = default;
+    };
+
+    static Brush brushOf(const AppState& state) { return {state.drawSize, state.drawChance, state.drawMaterial, state.drawShape}; }
+    static Sim   simOf(const AppState& state) { return {state.runSim, state.scanMode, state.fluidDispersionFactor, state.solidDispersionFactor}; }
+    void         apply(AppState& state) const;
+
+    void op(u8 code); // writes the pending TICKS first
+    void writeTicks();
+    void flush();
+
+    u8  current    = InputLogMode::OFF;
+    u32 ticks      = 0;
+    u32 totalTicks = 0;
+    u32 bytes      = 0;
+
+    // recording
+    std::ofstream   file;
+    std::vector<u8> buffer;
+    u32             idleTicks = 0;
+    bool            stroke    = false;
+
+    // replaying
+    std::vector<u8> log;
+    const u8*       read    = nullptr;
+    u32             tickRun = 0;     // frames left in the current TICKS
+    bool            ticked  = false; // the last event was a TICKS, the caller has run a frame since
+    bool            corrupt = false;
+
+    // both, the last settings written / read and the last DRAW position.
+    Brush brush{};
+    Sim   sim{};
+    s32   drawX = 0, drawY = 0;
+};
+
+// Headless replay at full speed, `app --replay <log>`. Prints per-stage timings as it goes.
+int runReplay(const std::string& path);
@@ -21,5 +21,10 @@ private:
     bool     showDemoWindow = true;
     f32      frameRate      = 0;
     u8       loadedTex      = 0;
+    int      pendingWidth   = 0; // game window size waiting to settle, see gameWindow()
+    int      pendingHeight  = 0;
+    f64      pendingSince   = 0;
+    f32      dragX          = 0; // middle mouse drag not yet a whole cell, see gameWindow()
+    f32      dragY          = 0;
     ImGuiIO& io             = ImGui::GetIO();
 };
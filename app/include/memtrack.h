@@ -0,0 +1,40 @@
+#pragma once
+#include "state.h"
+
+// Heap accounting. The global operator new is replaced in memtrack.cpp, every block carries a small header
+// with its size & MemoryTag, so a free is credited back to whatever allocated it, wherever it's freed.
+// Code says what it's allocating with a MemoryScope, anything outside one counts as MemoryTag::OTHER.
+// ImGui is pointed at trackedAlloc() in Framework::init(), SDL & the GL driver use malloc and aren't seen.
+
+struct MemoryStats {
+    std::array<u64, MemoryTag::COUNT> liveBytes{};
+    std::array<u64, MemoryTag::COUNT> liveBlocks{};
+    std::array<u64, MemoryTag::COUNT> peakBytes{};   // since the last resetMemoryPeaks()
+    std::array<u64, MemoryTag::COUNT> allocations{}; // since startup
+    u64                               totalBytes = 0;
+    u64                               totalPeak  = 0;
+};
+
+// Tags every allocation made on this thread until it goes out of scope, scopes nest.
+class MemoryScope {
+public:
+    explicit MemoryScope(u8 tag);
+    ~MemoryScope();
+    MemoryScope(const MemoryScope&)            = delete;
+    MemoryScope& operator=(const MemoryScope&) = delete;
+
+private:
+    u8 previous;
+};
+
+u64         heapAllocations(); // allocations of any tag since startup
+MemoryStats memoryStats();
+void        resetMemoryPeaks(); // peaks restart from what's live now
+void        printMemoryReport(); // a line per tag, for headless runs
+
+void* trackedAlloc(size_t bytes, u8 tag); // for allocators that aren't operator new, freed with trackedFree()
+void  trackedFree(void* ptr);
+
+// asks for 2MB pages under a big block that hasn't been touched yet, a 4K world is ~16 page faults instead of ~8000.
+// Only a hint: a no-op off Linux & for small blocks, the kernel may still say no.
+void adviseHugePages(void* ptr, size_t bytes);
@@ -0,0 +1,11 @@
+#pragma once
+#include "state.h"
+
+// Pixel format conversion into the texture's byte order, R | G | B | A (see packRGBA()).
+// Converts 'count' pixels of a single row, call once per row so surface pitch padding gets skipped.
+// SSSE3 shuffle kernels, picked at runtime from cpuFeatures(), scalar otherwise.
+void rgb24ToRGBA(const u8* src, u32 count, u8* dst);  // R, G, B bytes (SDL_PIXELFORMAT_RGB24), alpha becomes 255
+void argbToRGBA(const u32* src, u32 count, u8* dst); // packed 0xAARRGGBB (SDL_PIXELFORMAT_ARGB8888), B, G, R, A in memory
+
+// Name of the kernel set in use, for the debug menu.
+std::string_view pixelFormatKernelName();
@@ -0,0 +1,106 @@
+#pragma once
+#include "dirty.h"
+#include "memtrack.h"
+#include "state.h"
+#include <algorithm>
+
+// Which chunks the sim steps this frame, by how far they are from the camera, see SimTier.
+// Chunks in view are stepped every frame. Ones just off screen are stepped every 'interval' frames with their
+// dispersion scaled up by as much (see Game::dispersion()), so sand & water still cover the same ground on average.
+// Further out a chunk sleeps, unless something moved in it or on its edge: a neighbour pouring into it, sand
+// that was resting on a neighbour that's just been dug out, the brush, a rewind. A woken chunk is stepped like a
+// near one until a step changes nothing in it or along its edges, then it goes back to sleep.
+//
+// Chunks are the ChunkMap's, one DirtyBitmap tile wide, so the tiles marked each frame say what moved where.
+class RegionScheduler {
+public:
+    static constexpr u16 CHUNK_SIZE = 64; // == ChunkMap::CHUNK_SIZE
+
+    // sizes the schedule to the grid. Whatever was there is new, it all gets stepped until it settles.
+    void resize(u16 cellWidth, u16 cellHeight) {
+        MemoryScope tag(MemoryTag::CHUNKS);
+        cols = (cellWidth + CHUNK_SIZE - 1) / CHUNK_SIZE;
+        rows = (cellHeight + CHUNK_SIZE - 1) / CHUNK_SIZE;
+        tiers.assign(static_cast<size_t>(cols) * rows, SimTier::ACTIVE);
+        steps.assign(tiers.size(), 1);
+        awake.assign(tiers.size(), true);
+        touchedAt.assign(tiers.size(), 0);
+    }
+
+    // The grid moved under the schedule, chunk (cx, cy) is what was at (cx + dx, cy + dy). Chunks that stay in
+    // the window keep whether they were awake, the ones coming in from the store wake up, nothing's known about them.
+    void shift(s32 dx, s32 dy) {
+        const s32 offset = (dy * cols) + dx; // in place, reading ahead of the write or behind it
+        auto      move   = [&](s32 cx, s32 cy) -> void {
+            const s32 fromX = cx + dx, fromY = cy + dy;
+            awake[(cy * cols) + cx] = fromX >= 0 && fromX < cols && fromY >= 0 && fromY < rows ? awake[(cy * cols) + cx + offset] : true;
+        };
+        if (offset > 0)
+            for (s32 cy = 0; cy < rows; cy++)
+                for (s32 cx = 0; cx < cols; cx++) move(cx, cy);
+        else
+            for (s32 cy = rows - 1; cy >= 0; cy--)
+                for (s32 cx = cols - 1; cx >= 0; cx--) move(cx, cy);
+    }
+
+    // Tiers every chunk from the view (in cells) & works out which are due this frame. NEAR & WOKEN chunks
+    // are staggered by position, so they don't all land on the same frame. Off, every chunk is ACTIVE.
+    void plan(u32 frame, s32 viewX, s32 viewY, u16 viewCols, u16 viewRows, u8 nearChunks, u8 interval, bool enabled) {
+        const s32 x0 = viewX / CHUNK_SIZE, x1 = (viewX + std::max<s32>(viewCols, 1) - 1) / CHUNK_SIZE;
+        const s32 y0 = viewY / CHUNK_SIZE, y1 = (viewY + std::max<s32>(viewRows, 1) - 1) / CHUNK_SIZE;
+        interval     = std::max<u8>(interval, 1);
+        counts.fill(0);
+        for (s32 cy = 0; cy < rows; cy++)
+            for (s32 cx = 0; cx < cols; cx++) {
+                const u32 chunk    = (cy * cols) + cx;
+                const s32 distance = std::max({x0 - cx, cx - x1, y0 - cy, cy - y1, 0});
+                u8        tier     = SimTier::ACTIVE;
+                if (enabled && distance > 0) tier = distance <= nearChunks ? SimTier::NEAR : awake[chunk] ? SimTier::WOKEN : SimTier::ASLEEP;
+
+                tiers[chunk] = tier;
+                counts[tier]++;
+                if (tier == SimTier::ACTIVE) steps[chunk] = 1;
+                else if (tier == SimTier::ASLEEP) steps[chunk] = 0;
+                else steps[chunk] = (frame + cx + cy) % interval == 0 ? interval : 0;
+            }
+        stepped = true;
+    }
+
+    // Chunks with a marked tile changed this frame, & so did their neighbours along it. A sleeping one wakes
+    // up, one that was just stepped & didn't change settles. Nothing settles on a frame the sim didn't run.
+    void touch(const DirtyBitmap& changed) {
+        pass++;
+        changed.forEachTile([&](u16 x, u16 y) -> void {
+            // a tile's one row of a chunk, both sides of it are on an edge. Above & below only for the top & bottom rows.
+            const s32 cx = x / CHUNK_SIZE, cy = y / CHUNK_SIZE;
+            const s32 top = y % CHUNK_SIZE == 0 ? cy - 1 : cy, bottom = y % CHUNK_SIZE == CHUNK_SIZE - 1 ? cy + 1 : cy;
+            for (s32 ny = std::max<s32>(top, 0); ny <= std::min<s32>(bottom, rows - 1); ny++)
+                for (s32 nx = std::max<s32>(cx - 1, 0); nx <= std::min<s32>(cx + 1, cols - 1); nx++) touchedAt[(ny * cols) + nx] = pass;
+        });
+        for (u32 chunk = 0; chunk < tiers.size(); chunk++) {
+            if (touchedAt[chunk] == pass) awake[chunk] = true;
+            else if (stepped && steps[chunk]) awake[chunk] = false;
+        }
+        stepped = false;
+    }
+
+    u8  step(u16 cx, u16 cy) const { return steps[(cy * cols) + cx]; } // 0 == not this frame, else the dispersion scale
+    u8  tier(u16 cx, u16 cy) const { return tiers[(cy * cols) + cx]; }
+    u16 colCount() const { return cols; }
+    u16 rowCount() const { return rows; }
+    u32 tierCount(u8 tier) const { return counts[tier]; }
+
+    const std::vector<u8>& tierMap() const { return tiers; } // row by row, for the debug view
+
+private:
+    u16  cols = 0, rows = 0;
+    u32  pass    = 0;     // touch() count, touchedAt[chunk] == pass if it changed this time
+    bool stepped = false; // plan() ran since the last touch(), i.e. the sim did
+
+    std::array<u32, SimTier::COUNT> counts{};
+
+    std::vector<u8>  tiers;
+    std::vector<u8>  steps;
+    std::vector<u8>  awake; // changed since it was last stepped, or never settled
+    std::vector<u32> touchedAt;
+};
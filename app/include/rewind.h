@@ -0,0 +1,132 @@
+#pragma once
+#include "cell.h"
+#include "state.h"
+#include <algorithm>
+#include <deque>
+
+// Bounded history of the world for scrubbing the simulation backwards (and forwards again).
+//
+// Every cell change goes through record() before it's written, the first change to a cell in a step keeps
+// its 'before' value, commit() fills in the 'after' values & closes the step. A step is one Game::update(),
+// so a sim frame plus whatever was painted in it. Moving between steps applies befores (back) or afters
+// (forwards), so it costs the number of cells changed on the way, not the world size.
+//
+// Once enough changes pile up that replaying them would cost more than decoding the world, an RLE keyframe
+// is taken, seek() starts from whichever keyframe (or the current position) is closest in changes.
+// The oldest steps are dropped to stay under the memory budget.
+class RewindBuffer {
+public:
+    void resize(u16 width, u16 height, u8 nVariants); // also forgets the history
+    void clear(u32 frame, u64 seed);                                 // the world jumped, start over from here
+
+    bool recording() const { return budget > 0; }
+    void record(u32 idx, const Cell& before) {
+        u64& word = touched[idx >> 6];
+        const u64 bit = u64(1) << (idx & 63);
+        if (word & bit) return; // only the first change this step, that's the value to go back to.
+        word |= bit;
+        pending.push_back({idx, before, before});
+    }
+
+    // closes the current step, anything after the cursor (i.e. rewound over) is thrown away first.
+    void commit(const Cell* cells, u32 frame, u64 seed);
+    void setBudget(u64 bytes, u32 frame, u64 seed); // turning recording on starts the history from (frame, seed)
+
+    // Moves the world to history position 'target', calling changed(idx) for each cell it rewrites.
+    // Returns true if it restored a keyframe instead, the whole world needs redrawing.
+    template <typename Func>
+    bool seek(u64 target, Cell* cells, u32& frame, u64& seed, Func&& changed);
+
+    u64 oldest() const { return base; }
+    u64 newest() const { return base + steps.size(); }
+    u64 position() const { return cursor; }
+    u64 byteCount() const { return bytes; }
+    u32 keyframeCount() const { return keyframes.size(); }
+
+private:
+    struct CellChange {
+        u32  idx;
+        Cell before, after;
+    };
+
+    struct Step {
+        u64 firstChange; // index into 'changes', counting the ones already dropped
+        u32 changeCount;
+        u32 frame; // frame & seed once the step is applied
+        u64 seed;
+    };
+
+    struct Keyframe {
+        u64             position;
+        u32             frame;
+        u64             seed;
+        std::vector<u8> cells; // RLE, see SnapshotEncoding::RLE
+    };
+
+    u64 changeIdx(u64 position) const { return position == newest() ? firstChange + changes.size() : steps[position - base].firstChange; }
+    u32 frameAt(u64 position) const { return position == base ? baseFrame : steps[position - base - 1].frame; }
+    u64 seedAt(u64 position) const { return position == base ? baseSeed : steps[position - base - 1].seed; }
+    void takeKeyframe(const Cell* cells);
+    void truncate(); // drops everything after the cursor
+    void evict();    // drops the oldest steps until we're under budget
+    void restoreKeyframe(const Keyframe& keyframe, Cell* cells);
+
+    u16 width = 0, height = 0;
+    u8  nVariants = 0;
+
+    u64 budget        = 0; // bytes, 0 == not recording
+    u64 bytes         = 0;
+    u64 base          = 0; // oldest position we can still reach
+    u64 cursor        = 0; // where the world currently is
+    u64 firstChange   = 0; // index of changes.front()
+    u64 sinceKeyframe = 0; // changes recorded since the last keyframe
+    u32 baseFrame     = 0;
+    u64 baseSeed      = 0;
+
+    std::vector<u64>        touched; // one bit per cell, set if it's in 'pending'
+    std::vector<CellChange> pending; // this step's changes, 'after' filled in by commit()
+    std::deque<CellChange>  changes;
+    std::deque<Step>        steps; // steps[i] goes from position base + i to base + i + 1
+    std::deque<Keyframe>    keyframes;
+};
+
+template <typename Func>
+bool RewindBuffer::seek(u64 target, Cell* cells, u32& frame, u64& seed, Func&& changed) {
+    target = std::clamp(target, oldest(), newest());
+    if (target == cursor) return false;
+
+    // start from wherever is the fewest changes away, decoding a keyframe counts as a change per 4 cells.
+    auto distance = [&](u64 from) -> u64 { return from < target ? changeIdx(target) - changeIdx(from) : changeIdx(from) - changeIdx(target); };
+    const Keyframe* start = nullptr;
+    u64             best  = distance(cursor);
+    for (const Keyframe& keyframe : keyframes) {
+        const u64 cost = (static_cast<u64>(width) * height / 4) + distance(keyframe.position);
+        if (cost < best) {
+            best  = cost;
+            start = &keyframe;
+        }
+    }
+    const bool redraw = start != nullptr;
+    if (redraw) {
+        restoreKeyframe(*start, cells);
+        cursor = start->position;
+    }
+
+    auto apply = [&](const CellChange& change, const Cell& value) -> void {
+        cells[change.idx]         = value;
+        cells[change.idx].updated = false;
+        if (!redraw) changed(change.idx);
+    };
+    for (; cursor > target; cursor--) {
+        const Step& step = steps[cursor - base - 1];
+        for (u64 i = step.firstChange; i < step.firstChange + step.changeCount; i++) apply(changes[i - firstChange], changes[i - firstChange].before);
+    }
+    for (; cursor < target; cursor++) {
+        const Step& step = steps[cursor - base];
+        for (u64 i = step.firstChange; i < step.firstChange + step.changeCount; i++) apply(changes[i - firstChange], changes[i - firstChange].after);
+    }
+
+    frame = frameAt(cursor);
+    seed  = seedAt(cursor);
+    return redraw;
+}
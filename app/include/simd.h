@@ -0,0 +1,50 @@
+#pragma once
+#include "state.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define PIXEL_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// MSVC lets you use any intrinsic anywhere, gcc/clang (and MinGW) need the instruction set
+// spelled out per function, otherwise the AVX2 kernels won't compile without -mavx2 for the whole program.
+#if defined(_MSC_VER) && !defined(__clang__)
+#define TARGET_SSSE3
+#define TARGET_AVX2
+#else
+#define TARGET_SSSE3 __attribute__((target("ssse3")))
+#define TARGET_AVX2  __attribute__((target("avx2")))
+#endif
+
+struct CpuFeatures {
+    bool sse2  = false;
+    bool ssse3 = false;
+    bool avx2  = false;
+};
+
+// queried once, the first time anything asks. x64 always has sse2, the rest depends on the machine.
+inline const CpuFeatures& cpuFeatures() {
+    static const CpuFeatures features = []() -> CpuFeatures {
+        CpuFeatures f;
+#if defined(PIXEL_X86) && defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 1);
+        f.sse2             = info[3] & (1 << 26);
+        f.ssse3            = info[2] & (1 << 9);
+        const bool osxsave = info[2] & (1 << 27);              // OS saves the ymm registers on context switch?
+        const bool ymmOS   = osxsave && (_xgetbv(0) & 6) == 6; // ^^ without this AVX instructions fault.
+        __cpuidex(info, 7, 0);
+        f.avx2 = ymmOS && (info[1] & (1 << 5));
+#elif defined(PIXEL_X86)
+        __builtin_cpu_init();
+        f.sse2  = __builtin_cpu_supports("sse2");
+        f.ssse3 = __builtin_cpu_supports("ssse3");
+        f.avx2  = __builtin_cpu_supports("avx2");
+#endif
+        return f;
+    }();
+    return features;
+}
@@ -0,0 +1,117 @@
+#pragma once
+#include "state.h"
+
+// Binary world snapshots, see Game::saveSnapshot() & Game::loadSnapshot().
+//
+// Layout: a fixed 64 byte SnapshotHeader, then planeBytes of cells in one of two encodings:
+//
+// RAW: cellWidth * cellHeight Cells exactly as they sit in memory (row major, 4 bytes each, little endian).
+//      Because the plane on disk == the plane in memory, a large save is mapped straight in and
+//      used as the cell storage, no parsing or copying. See MappedFile & CellBuffer.
+//
+// RLE: one record per row, no external dependencies.
+//      u8 flags    ROW_REPEAT: matIDs are the same as the row above, ROW_NO_DATA: every data byte is 0
+//      matIDs      unless ROW_REPEAT, runs of (u8 matID, varint length) covering the row
+//      variants    bit packed, bit_width(nVariants - 1) bits per cell, padded to a whole byte
+//      data        unless ROW_NO_DATA, runs of (u8 data, varint length) covering the row
+//      'updated' isn't stored, it's only meaningful mid-frame.
+//
+// The plane is the window, its top left corner at chunk (worldX, worldY). The rest of the world follows
+// in chunkBytes of chunk records, RLE whatever the encoding, one per chunk in the ChunkStore (see StoredChunk):
+//      s32 cx, s32 cy  chunk coordinates in the world
+//      u8 flags        UNIFORM: all 'material', no cells. ARRIVING: the window only has placeholders for it
+//      u8 material     if UNIFORM
+//      u32 length      RLE bytes that follow, 64 rows of 64 cells as above. 0 if UNIFORM
+struct SnapshotHeader {
+    static constexpr u32 MAGIC   = 0x56535850; // "PXSV"
+    static constexpr u16 VERSION = 3;          // 1 == raw only, no encoding byte. 2 == no world position or chunks
+
+    u32 magic        = MAGIC;
+    u16 version      = VERSION;
+    u16 headerBytes  = 64; // offset of the cell plane, lets later versions grow the header.
+    u16 cellWidth    = 0;
+    u16 cellHeight   = 0;
+    u8  scaleFactor  = 0;
+    u8  cellBytes    = 0; // sizeof(Cell) when saved, a different Cell layout can't be adopted.
+    u8  nMaterials   = 0;
+    u8  nVariants    = 0;
+    u32 frame        = 0;
+    u8  encoding     = SnapshotEncoding::RAW;
+    u8  reserved[3]  = {};
+    u64 seed         = 0;
+    u64 materialHash = 0; // materials changing under a save would silently turn sand into water..
+    u64 planeBytes   = 0;
+    s32 worldX       = 0; // chunk of the plane's top left corner
+    s32 worldY       = 0;
+    u64 chunkBytes   = 0; // of chunk records after the plane
+};
+static_assert(sizeof(SnapshotHeader) == 64, "snapshot header is written as-is, keep it 64 bytes");
+
+struct Cell;
+
+// A chunk from outside the window, on its way to or from a snapshot. See ChunkStore::collect().
+struct StoredChunk {
+    static constexpr u8  UNIFORM      = 1 << 0;
+    static constexpr u8  ARRIVING     = 1 << 1;
+    static constexpr u64 RECORD_BYTES = 14; // cx, cy, flags, material, length, before the cells
+
+    s32             cx = 0, cy = 0;
+    u8              flags    = 0;
+    u8              material = 0;
+    std::vector<u8> cells; // RLE, see encodeCells(). Empty if UNIFORM
+};
+
+// LEB128, 7 bits a byte, low bits first. Also used by the input log.
+inline void putVarint(std::vector<u8>& out, u32 value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<u8>(value) | 0x80);
+        value >>= 7;
+    }
+    out.push_back(static_cast<u8>(value));
+}
+
+inline bool getVarint(const u8*& p, const u8* end, u32& value) {
+    value = 0;
+    for (u32 shift = 0; p < end && shift < 32; shift += 7) {
+        const u8 byte = *p++;
+        value |= static_cast<u32>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+// Writes header.cellWidth * header.cellHeight cells in header.encoding, then the chunks. Fills in planeBytes & chunkBytes itself.
+bool writeSnapshot(const std::string& path, SnapshotHeader header, const Cell* cells, const std::vector<StoredChunk>& chunks);
+
+// The RLE plane on its own, in memory. Used for rewind keyframes, decodeCells() trusts its input.
+void encodeCells(const Cell* cells, u16 width, u16 height, u8 nVariants, std::vector<u8>& out);
+void decodeCells(const std::vector<u8>& plane, Cell* cells, u16 width, u16 height, u8 nVariants);
+
+// Read-only file mapped copy-on-write: writes go to private pages, the file itself never changes.
+// Untouched pages are shared with the OS file cache, so 'loading' costs nothing until they're read.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+
+    MappedFile(MappedFile&& other) noexcept { *this = std::move(other); }
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    MappedFile(const MappedFile&)            = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    u8*                data() const { return base; }
+    size_t             size() const { return bytes; }
+    const std::string& path() const { return filePath; }
+
+private:
+    u8*         base  = nullptr;
+    size_t      bytes = 0;
+    std::string filePath;
+#ifdef _WIN32
+    void* file    = nullptr; // HANDLE, kept as void* so windows.h stays out of the headers.
+    void* mapping = nullptr;
+#endif
+};
@@ -2,19 +2,20 @@
 #define SDL_MAIN_HANDLED
 #include <array>
 #include <cstdint>
+#include <string>
 #include <string_view>
 #include <vector>
 
 // Type Definitions
-using u8  = unsigned char;
-using u16 = unsigned short;
-using u32 = unsigned long int;
-using u64 = unsigned long long;
+using u8  = std::uint8_t;
+using u16 = std::uint16_t;
+using u32 = std::uint32_t; // long int is only 32 bits on windows, packed RGBA needs exactly 32.
+using u64 = std::uint64_t;
 
 using s8  = char;
-using s16 = short;
-using s32 = long int;
-using s64 = long long;
+using s16 = std::int16_t;
+using s32 = std::int32_t;
+using s64 = std::int64_t;
 
 using f32 = float;
 using f64 = double;
@@ -139,6 +140,23 @@ struct Scan {
     };
 };
 
+// how often the sim steps a chunk, see RegionScheduler.
+struct SimTier {
+    enum : u8 {
+        ACTIVE, // on screen, every frame
+        NEAR,   // just off screen, every lodInterval frames
+        WOKEN,  // far off, but something moved in it. Stepped like NEAR until it settles
+        ASLEEP, // far off & settled, not stepped at all
+        COUNT,
+    };
+
+    static constexpr std::array<std::string_view, SimTier::COUNT> names{
+        "Active",
+        "Near",
+        "Woken",
+        "Asleep",
+    };
+};
 
 struct Shape {
     enum : u8 {
@@ -147,6 +165,7 @@ struct Shape {
         LINE,
         SQUARE,
         SQUARE_OUTLINE,
+        FILL,
         COUNT,
     };
 
@@ -156,13 +175,76 @@ struct Shape {
         "Line",
         "Square",
         "Square Outline",
+        "Fill",
     };
 };
 
+struct SnapshotEncoding {
+    enum : u8 {
+        RAW,
+        RLE,
+        COUNT,
+    };
+
+    static constexpr std::array<std::string_view, SnapshotEncoding::COUNT> names{
+        "Raw",
+        "RLE",
+    };
+};
+
+struct InputLogMode {
+    enum : u8 {
+        OFF,
+        RECORDING,
+        REPLAYING,
+        COUNT,
+    };
+
+    static constexpr std::array<std::string_view, InputLogMode::COUNT> names{
+        "Off",
+        "Recording",
+        "Replaying",
+    };
+};
+
+// what heap memory is for, see memtrack.h
+struct MemoryTag {
+    enum : u8 {
+        OTHER,
+        CELLS,
+        TEXTURES,
+        PALETTE,
+        CHANGE_LISTS,
+        CHUNKS,
+        FRAME_ARENA,
+        IMGUI,
+        COUNT,
+    };
+
+    static constexpr std::array<std::string_view, MemoryTag::COUNT> names{
+        "Other",
+        "Cells",
+        "Textures",
+        "Palette",
+        "Change Lists",
+        "Chunk Metadata",
+        "Frame Arena",
+        "ImGui",
+    };
+};
+
+// part of a texture, in texels.
+struct TexRect {
+    u16 x = 0, y = 0, width = 0, height = 0;
+};
+
 struct TextureData {
-    GLuint          id     = 0; // can't be u8 because ptrs.
-    u16             width  = 0;
-    u16             height = 0;
+    GLuint          id             = 0; // can't be u8 because ptrs.
+    u16             width          = 0;
+    u16             height         = 0;
+    u16             capacityWidth  = 0; // size of the GL texture, only the top left width x height is used.
+    u16             capacityHeight = 0; // grows by half again when outgrown, see Framework::resizeTexture()
+    bool            reallocated    = false; // the GL texture lost its contents, the next upload has to be all of it.
     std::vector<u8> data;
 
     TextureData(u32 ID, u16 WIDTH, u16 HEIGHT, std::vector<u8> DATA) {
@@ -175,14 +257,34 @@ struct TextureData {
 };
 
 struct AppState {
-    std::vector<TextureData> textures;
-    std::string              imagePath;
+    std::vector<TextureData>         textures;
+    std::vector<std::pair<u16, u16>> drawIndicators; // brush outline in cells from the top left of the view, drawn as an overlay
+    std::vector<TexRect>             textureUploads; // parts of the game texture the last Game::update() wrote
+    std::vector<u8>                  simTiers;       // SimTier of each chunk, row by row, only filled in while showSimTiers is set
+    std::string                      imagePath;
+    std::string                      savePath; // snapshot to save to / load from
+    std::string                      autosavePath = "../Resources/Saves/autosave.pxsv";
+    std::string                      inputLogPath; // input log to record to / replay from
+    std::string                      chunkStorePath = "../Resources/Saves/world.chunks"; // chunks evicted from memory, only for this session
 
     // Efficient Flag: u64 flags = 0;
     bool runSim     = false;
     bool resetSim   = false;
     bool reloadGame = false;
     bool loadImage  = false;
+    bool saveGame   = false;
+    bool loadGame   = false;
+    bool seekRewind = false;
+
+    bool skipUniformChunks = true; // skip chunks of inert material in the sim, see ChunkMap
+    bool simLod            = true; // step chunks away from the camera less often, see RegionScheduler
+    bool showSimTiers      = false;
+
+    bool startRecording = false;
+    bool startReplay    = false;
+    bool stopInputLog   = false;
+
+    u8 saveEncoding = SnapshotEncoding::RLE;
 
     u8 scanMode              = Scan::BOTTOM_UP_LEFT;
     u8 updateMode            = Update::CYCLE;
@@ -197,8 +299,86 @@ struct AppState {
     u16 mouseY   = 0;
     u16 drawSize = 10;
 
-    u32 frame          = 0;
-    u32 texReloadCount = 0;
-    u32 textureChanges = 0;
-    u32 cellChanges    = 0;
+    u32 frame           = 0;
+    u32 texReloadCount  = 0;
+    u32 texReallocCount = 0; // GL textures that outgrew their capacity
+    u32 textureRequests = 0; // texture writes asked for, duplicates included
+    u32 textureChanges  = 0; // texture writes performed
+    u32 cellChanges     = 0;
+    u32 uniformChunks   = 0; // chunks that are all one material, see ChunkMap
+    u32 chunkCount      = 0;
+
+    u8                              lodNearChunks = 2; // how far past the view (in chunks) the NEAR tier goes
+    u8                              lodInterval   = 4; // frames between steps of a NEAR / WOKEN chunk
+    u16                             simTierCols   = 0; // chunks per row of simTiers
+    std::array<u32, SimTier::COUNT> tierChunks{};      // chunks in each tier, last frame the sim ran
+
+    u32 brushCacheHits   = 0;
+    u32 brushCacheMisses = 0;
+    u32 brushCacheStamps = 0;
+    u32 brushCacheBytes  = 0;
+
+    f32 snapshotMs = 0; // how long the last save / load took
+
+    u64 frameAllocs     = 0; // heap allocations over the last whole frame, see heapAllocations()
+    u64 frameAllocsPeak = 0; // most in a single frame, since the last reset of the memory panel's peaks
+    u64 updateAllocs    = 0; // of those, inside Game::update()
+    u64 arenaUsed       = 0; // bytes of frame scratch the last Game::update() used
+    u64 arenaCapacity   = 0;
+    u64 arenaHighWater  = 0;
+
+    u16 resizeSettleMs = 150; // the game window has to hold its size this long before the world is resized
+
+    u16 autosaveInterval = 60; // seconds, 0 == off
+    u32 autosaveCount    = 0;
+    u32 autosaveChunks   = 0; // chunks copied by the last autosave
+    u32 autosaveTotal    = 0; // chunks in the world
+    f32 autosaveStallMs  = 0; // time the sim waited on the last autosave
+    f32 autosaveSaveMs   = 0; // time the background thread spent writing it
+
+    static constexpr u8 MAX_ZOOM = 32;
+
+    s32 viewX        = 0; // cell in the camera's top left corner, Game::update() clamps it to the grid
+    s32 viewY        = 0;
+    u8  zoom         = 0; // texels per cell, 0 == scaleFactor
+    u32 visibleCells = 0;
+
+    s32  panX               = 0; // chunks to move the window by, Game::update() takes them
+    s32  panY               = 0;
+    s32  worldX             = 0; // chunk the window's top left corner is in
+    s32  worldY             = 0;
+    bool panPending         = false; // waiting on chunks to load
+    u16  chunkBudget        = 64;    // MB of chunks to keep in memory outside the window
+    u32  residentChunks     = 0;
+    u64  residentChunkBytes = 0;
+    u32  storedChunks       = 0; // chunks with a slot in the chunk store file
+    u32  taggedChunks       = 0; // chunks kept as just their material, no cells or slot
+    u64  taggedChunkBytes   = 0; // what their cells would take
+    u32  loadingChunks      = 0;
+    u32  chunkReads         = 0;
+    u32  chunkWrites        = 0;
+
+    // MB of history to keep, 0 == off. On by default so the scrubber works without setting anything up. 64 MB is
+    // ~20 s of settling sand at 1080p but only a second or two of busy water, the oldest steps go first either way.
+    u16 rewindBudget    = 64;
+    u64 rewindTarget    = 0;  // history position to seek to when seekRewind is set
+    u64 rewindOldest    = 0;
+    u64 rewindNewest    = 0;
+    u64 rewindPosition  = 0;
+    u64 rewindBytes     = 0;
+    u32 rewindKeyframes = 0;
+    f32 rewindSeekMs    = 0;
+
+    u8  inputLogMode   = InputLogMode::OFF;
+    u32 inputLogTicks  = 0; // frames recorded / replayed so far
+    u32 inputLogLength = 0; // frames in the log being replayed
+    u32 inputLogBytes  = 0;
+
+    std::array<f32, Message::COUNT> startupMs{}; // time each startup stage took, see Framework::init()
+
+    // per-stage timings of the last frame, see Game::update()
+    f32 drawMs    = 0; // brush strokes
+    f32 simMs     = 0; // Game::simulate()
+    f32 textureMs = 0; // texture writer
+    f32 historyMs = 0; // autosave capture + rewind commit
 };
@@ -0,0 +1,36 @@
+#pragma once
+#include "arena.h"
+#include "memtrack.h"
+#include <algorithm>
+
+void* FrameArena::allocate(size_t bytes, size_t align) {
+    if (!blocks.empty()) {
+        const size_t start = (offset + align - 1) & ~(align - 1);
+        if (start + bytes <= blocks.back().size) {
+            usedBytes += start + bytes - offset;
+            offset = start + bytes;
+            return blocks.back().data.get() + start;
+        }
+    }
+
+    // doesn't fit, chain on a block at least as big as everything so far. new[] of u8 is only aligned
+    // to __STDCPP_DEFAULT_NEW_ALIGNMENT__, which covers everything kept in here.
+    MemoryScope  tag(MemoryTag::FRAME_ARENA);
+    const size_t size = std::max({MIN_BLOCK, capacityBytes, bytes});
+    blocks.push_back({std::make_unique_for_overwrite<u8[]>(size), size});
+    capacityBytes += size;
+    usedBytes += bytes;
+    offset = bytes;
+    return blocks.back().data.get();
+}
+
+void FrameArena::reset() {
+    highWaterBytes = std::max(highWaterBytes, usedBytes);
+    if (blocks.size() > 1) {
+        MemoryScope tag(MemoryTag::FRAME_ARENA);
+        blocks.clear();
+        blocks.push_back({std::make_unique_for_overwrite<u8[]>(capacityBytes), capacityBytes});
+    }
+    offset    = 0;
+    usedBytes = 0;
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include "autosave.h"
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+
+void Autosave::resize(u16 cellWidth, u16 cellHeight) {
+    wait(); // the writer might still be reading the old mirror.
+    width     = cellWidth;
+    height    = cellHeight;
+    chunkCols = (cellWidth + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    chunkRows = (cellHeight + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    MemoryScope chunksTag(MemoryTag::CHUNKS);
+    dirty.assign(chunkCols * chunkRows, true);
+    MemoryScope cellsTag(MemoryTag::CELLS);
+    mirror.resize(static_cast<size_t>(width) * height);
+}
+
+bool Autosave::capture(const Cell* cells, const SnapshotHeader& header, const std::string& path, std::future<std::vector<StoredChunk>> chunks) {
+    if (writing || header.cellWidth != width || header.cellHeight != height) return false;
+    if (writer.joinable()) writer.join();
+
+    // neighbouring dirty chunks in a chunk row are copied together, one memcpy per cell row.
+    const auto start  = std::chrono::steady_clock::now();
+    u32        copied = 0;
+    for (u16 cy = 0; cy < chunkRows; cy++)
+        for (u16 cx = 0; cx < chunkCols;) {
+            if (!dirty[(cy * chunkCols) + cx]) {
+                cx++;
+                continue;
+            }
+            u16 runEnd = cx;
+            while (runEnd < chunkCols && dirty[(cy * chunkCols) + runEnd]) dirty[(cy * chunkCols) + runEnd++] = false;
+            copied += runEnd - cx;
+
+            const u32 x0 = cx * CHUNK_SIZE;
+            const u32 x1 = std::min<u32>(runEnd * CHUNK_SIZE, width);
+            const u32 y1 = std::min<u32>((cy + 1) * CHUNK_SIZE, height);
+            for (u32 y = cy * CHUNK_SIZE; y < y1; y++) std::memcpy(&mirror[(y * width) + x0], &cells[(y * width) + x0], (x1 - x0) * sizeof(Cell));
+            cx = runEnd;
+        }
+    lastStallMs      = std::chrono::duration<f32, std::milli>(std::chrono::steady_clock::now() - start).count();
+    lastChunksCopied = copied;
+    saves++;
+
+    writing = true;
+    writer  = std::thread([this, header, path, chunks = std::move(chunks)]() mutable -> void {
+        const auto      start = std::chrono::steady_clock::now();
+        std::error_code error;
+        std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+        writeSnapshot(path, header, mirror.data(), chunks.get());
+        lastSaveMs = std::chrono::duration<f32, std::milli>(std::chrono::steady_clock::now() - start).count();
+        writing    = false;
+    });
+    return true;
+}
+
+void Autosave::wait() {
+    if (writer.joinable()) writer.join();
+}
@@ -0,0 +1,558 @@
+#pragma once
+#include "benchmark.h"
+#include "brush.h"
+#include "game.h"
+#include "pixelformat.h"
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+
+/*--------------------------------------------------------------------------------------
+---- Helpers ---------------------------------------------------------------------------
+--------------------------------------------------------------------------------------*/
+
+// runs foo() 'iterations' times, returns the average milliseconds per call.
+template <typename Func>
+static f64 timeMs(u32 iterations, Func&& foo) {
+    const auto start = std::chrono::steady_clock::now();
+    for (u32 i = 0; i < iterations; i++) foo();
+    const auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<f64, std::milli>(end - start).count() / iterations;
+}
+
+/*--------------------------------------------------------------------------------------
+---- Brush Rasterisers -----------------------------------------------------------------
+--------------------------------------------------------------------------------------*/
+
+// The per-cell std::function circle the span rasteriser replaced, kept here as the baseline.
+static void perCellCircle(s32 x, s32 y, s32 size, std::function<void(s32, s32)> foo) {
+    s32 r2   = size * size;
+    s32 area = r2 << 2;
+    s32 rr   = size << 1;
+    for (s32 i = 0; i < area; i++) {
+        s32 tX = (i % rr) - size;
+        s32 tY = (i / rr) - size;
+        if (tX * tX + tY * tY <= r2) foo(x + tX, y + tY);
+    }
+}
+
+static void perCellSquare(s32 x, s32 y, s32 size, std::function<void(s32, s32)> foo) {
+    for (s32 tY = -size / 2; tY < size / 2; tY++)
+        for (s32 tX = -size / 2; tX < size / 2; tX++) foo(x + tX, y + tY);
+}
+
+// Stamps a brush into a 4096x4096 grid (a 4K canvas at scaleFactor 1, roughly) with both paths.
+static void benchmarkBrush() {
+    constexpr s32   GRID = 4096;
+    std::vector<u8> grid(GRID * GRID);
+
+    auto plot = [&](s32 x, s32 y) -> void {
+        if (x >= 0 && y >= 0 && x < GRID && y < GRID) grid[(y * GRID) + x] = 1;
+    };
+    auto fillSpan = [&](s32 x, s32 y, s32 length) -> void { std::memset(&grid[(y * GRID) + x], 1, length); };
+    auto clipped  = clipSpans(GRID, GRID, fillSpan);
+
+    printf("%-8s %8s %16s %16s %10s\n", "shape", "size", "per-cell (ms)", "spans (ms)", "speedup");
+    for (u8 shape : {Shape::CIRCLE, Shape::SQUARE}) {
+        for (s32 size : {1, 10, 100, 1000, 10000}) {
+            const f64 area       = shape == Shape::CIRCLE ? 4.0 * size * size : f64(size) * size;
+            const u32 iterations = static_cast<u32>(std::max(1.0, 2e7 / std::max(area, 1.0)));
+
+            const f64 perCell = timeMs(iterations, [&]() -> void {
+                if (shape == Shape::CIRCLE) perCellCircle(GRID / 2, GRID / 2, size, plot);
+                else perCellSquare(GRID / 2, GRID / 2, size, plot);
+            });
+            const f64 spans = timeMs(iterations, [&]() -> void { rasterShape(shape, GRID / 2, GRID / 2, size, clipped); });
+
+            printf("%-8s %8d %16.4f %16.4f %9.1fx\n", Shape::names[shape].data(), size, perCell, spans, perCell / spans);
+        }
+    }
+}
+
+// Paints a size 1000 circle (~3.1M candidate cells) at various drawChance values,
+// one roll per candidate vs geometric-skip sampling. Painted fractions should match.
+static void benchmarkChance() {
+    constexpr s32   GRID = 4096;
+    std::vector<u8> grid(GRID * GRID);
+
+    u64  seed = 1234567890987654321;
+    auto rand = [&]() -> u64 { // same splitmix64 the game uses.
+        u64 z = (seed += UINT64_C(0x9E3779B97F4A7C15));
+        z     = (z ^ (z >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+        z     = (z ^ (z >> 27)) * UINT64_C(0x94D049BB133111EB);
+        return z ^ (z >> 31);
+    };
+
+    printf("%-8s %14s %14s %12s %12s %10s\n", "chance", "per-cell (ms)", "skip (ms)", "per-cell %", "skip %", "speedup");
+    for (u8 drawChance : {1, 5, 10, 25, 50, 90, 100}) {
+        u64 perCellPainted = 0, skipPainted = 0;
+
+        const f64 perCell = timeMs(5, [&]() -> void {
+            auto rollSpan = [&](s32 x, s32 y, s32 length) -> void {
+                u8* row = &grid[y * GRID];
+                for (s32 i = x; i < x + length; i++)
+                    if ((rand() % 100) + 1 <= drawChance) {
+                        row[i] = 1;
+                        perCellPainted++;
+                    }
+            };
+            rasterCircle(GRID / 2, GRID / 2, 1000, rollSpan);
+        });
+
+        ChanceSampler sampler(drawChance); // Game keeps one around, rebuilt when drawChance changes.
+        const f64     skip = timeMs(5, [&]() -> void {
+            u64  gap      = sampler.nextGap(rand);
+            auto skipSpan = [&](s32 x, s32 y, s32 length) -> void {
+                u8* row = &grid[y * GRID];
+                for (s32 baseX = x; baseX < x + length; baseX += 64) { // feed the run to the sampler a word at a time
+                    const s32 count = std::min(64, x + length - baseX);
+                    const u64 bits  = count == 64 ? ~u64(0) : (u64(1) << count) - 1;
+                    for (u64 painted = sampler.sampleBits(bits, gap, rand); painted; painted &= painted - 1) {
+                        row[baseX + std::countr_zero(painted)] = 1;
+                        skipPainted++;
+                    }
+                }
+            };
+            rasterCircle(GRID / 2, GRID / 2, 1000, skipSpan);
+        });
+
+        const f64 candidates = 5.0 * 3141592.0;
+        printf("%-8d %14.3f %14.3f %11.2f%% %11.2f%% %9.1fx\n",
+               drawChance,
+               perCell,
+               skip,
+               100.0 * perCellPainted / candidates,
+               100.0 * skipPainted / candidates,
+               perCell / skip);
+    }
+}
+
+/*--------------------------------------------------------------------------------------
+---- Snapshots -------------------------------------------------------------------------
+--------------------------------------------------------------------------------------*/
+
+// Saves & loads a 4K, scaleFactor 1 world (~8.3M cells, 33 MB raw) through a temp file, raw vs RLE, on a few scenes.
+// Load is timed up to the point the game could run its next frame on the new cells. Timings come out of the
+// OS file cache, so the 'slow disk' column adds the time a 100 MB/s disk would take to read the file first.
+static void benchmarkSnapshot() {
+    constexpr u16 WIDTH     = 3840;
+    constexpr u16 HEIGHT    = 2160;
+    constexpr f64 DISK_MBPS = 100.0;
+
+    Game            game;
+    AppState        state;
+    std::vector<u8> texture(WIDTH * HEIGHT * 4);
+    game.init(WIDTH, HEIGHT, 1);
+
+    const u8 materials[] = {MaterialID::SAND, MaterialID::WATER, MaterialID::CONCRETE, MaterialID::NATURAL_GAS};
+    auto     paintBlobs  = [&]() -> void {
+        for (u32 i = 0; i < 64; i++) {
+            game.mouseDraw((i * 997) % WIDTH, (i * 571) % HEIGHT, 150, 60, materials[i % 4], Shape::CIRCLE);
+            game.endStroke();
+        }
+    };
+
+    struct Scene {
+        const char* name;
+        std::function<void()> build;
+    };
+    const Scene scenes[] = {
+        {"empty", [&]() -> void { game.reset(); }},
+        {"blobs", [&]() -> void {
+             game.reset();
+             paintBlobs();
+         }},
+        {"settled", [&]() -> void { // blobs after the sim has had a while to pile things up.
+             game.reset();
+             paintBlobs();
+             state.runSim = true;
+             for (u32 i = 0; i < 60; i++) game.update(state, texture);
+             state.runSim = false;
+         }},
+        {"noise", [&]() -> void { // every cell a random material, worst case for RLE.
+             game.reset();
+             for (u8 material : materials) {
+                 game.mouseDraw(WIDTH / 2, HEIGHT / 2, WIDTH * 2, 40, material, Shape::SQUARE);
+                 game.endStroke();
+             }
+         }},
+    };
+
+    const std::string path = (std::filesystem::temp_directory_path() / "pixel_sim_benchmark.pxsv").string();
+    u32               frame = 0;
+
+    printf("%-8s %-5s %10s %8s %10s %10s %10s %10s %16s\n", "scene", "mode", "size (MB)", "ratio", "save (ms)", "load (ms)", "save MB/s", "load MB/s", "slow disk (ms)");
+    for (const Scene& scene : scenes) {
+        scene.build();
+        f64 rawBytes = 0;
+        for (u8 encoding = 0; encoding < SnapshotEncoding::COUNT; encoding++) {
+            const f64 save  = timeMs(5, [&]() -> void { game.saveSnapshot(path, 1234, encoding); });
+            const f64 load  = timeMs(5, [&]() -> void { game.loadSnapshot(path, frame); });
+            const f64 bytes = std::filesystem::file_size(path);
+            if (encoding == SnapshotEncoding::RAW) rawBytes = bytes;
+
+            printf("%-8s %-5s %10.2f %7.1fx %10.3f %10.3f %10.0f %10.0f %16.1f\n",
+                   scene.name,
+                   SnapshotEncoding::names[encoding].data(),
+                   bytes / 1e6,
+                   rawBytes / bytes,
+                   save,
+                   load,
+                   rawBytes / 1e3 / save, // throughput in world bytes, so both modes are comparable
+                   rawBytes / 1e3 / load,
+                   (bytes / 1e3 / DISK_MBPS) + load);
+        }
+    }
+
+    game.reset(); // drops the mapping before the file goes.
+    std::filesystem::remove(path);
+}
+
+/*--------------------------------------------------------------------------------------
+---- Image Import ----------------------------------------------------------------------
+--------------------------------------------------------------------------------------*/
+
+// Imports a 4K 'photo' (smooth gradients + grain) into worlds at a few scaleFactors.
+// The first import per world includes building the colour LUT. The baseline is the per-pixel nearest
+// colour search the LUT replaced, against a random palette of the same size, no downscaling.
+static void benchmarkImport() {
+    constexpr u16 WIDTH  = 3840;
+    constexpr u16 HEIGHT = 2160;
+
+    u64  seed = 1234567890987654321;
+    auto rand = [&]() -> u64 {
+        u64 z = (seed += UINT64_C(0x9E3779B97F4A7C15));
+        z     = (z ^ (z >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+        z     = (z ^ (z >> 27)) * UINT64_C(0x94D049BB133111EB);
+        return z ^ (z >> 31);
+    };
+
+    std::vector<u8> image(WIDTH * HEIGHT * 4);
+    for (u32 y = 0; y < HEIGHT; y++)
+        for (u32 x = 0; x < WIDTH; x++) {
+            const u32 grain = rand() & 15;
+            u8*       px    = &image[((y * WIDTH) + x) * 4];
+            px[0]           = static_cast<u8>((x * 255 / WIDTH + grain) & 0xFF);
+            px[1]           = static_cast<u8>((y * 255 / HEIGHT + grain) & 0xFF);
+            px[2]           = static_cast<u8>(((x + y) * 255 / (WIDTH + HEIGHT) + grain) & 0xFF);
+            px[3]           = 255;
+        }
+
+    printf("%-12s %12s %16s %14s\n", "scaleFactor", "cells", "first (ms)", "again (ms)");
+    for (u8 scaleFactor : {1, 2, 4, 10}) {
+        Game game;
+        game.init(WIDTH, HEIGHT, scaleFactor);
+        const f64 first = timeMs(1, [&]() -> void { game.loadImage(image, WIDTH, HEIGHT); });
+        const f64 again = timeMs(5, [&]() -> void { game.loadImage(image, WIDTH, HEIGHT); });
+        printf("%-12d %5dx%-6d %16.3f %14.3f\n", scaleFactor, WIDTH / scaleFactor, HEIGHT / scaleFactor, first, again);
+    }
+
+    // the floor for scaleFactor 1: every pixel read & a cell written per pixel, the same bytes each way.
+    std::vector<u8> copy(image.size());
+    const f64       memcpyMs = timeMs(5, [&]() -> void { std::memcpy(copy.data(), image.data(), image.size()); });
+    printf("memcpy of the %zu MB image: %.3f ms (%u)\n", image.size() >> 20, memcpyMs, copy[copy.size() / 2]); // read back, or it's optimised out
+
+    std::vector<u32> palette(MaterialID::COUNT * 20);
+    for (u32& colour : palette) colour = static_cast<u32>(rand());
+    std::vector<u8> nearest(WIDTH * HEIGHT);
+    const f64       search = timeMs(1, [&]() -> void {
+        for (u32 i = 0; i < WIDTH * HEIGHT; i++) {
+            const u8* px   = &image[i * 4];
+            s32       best = INT32_MAX;
+            for (u32 j = 0; j < palette.size(); j++) {
+                const s32 dR = px[0] - s32(palette[j] & 0xFF), dG = px[1] - s32((palette[j] >> 8) & 0xFF), dB = px[2] - s32((palette[j] >> 16) & 0xFF);
+                const s32 distance = (dR * dR) + (dG * dG) + (dB * dB);
+                if (distance < best) {
+                    best       = distance;
+                    nearest[i] = j;
+                }
+            }
+        }
+    });
+    printf("per-pixel nearest colour search, scaleFactor 1: %.3f ms\n", search);
+}
+
+/*--------------------------------------------------------------------------------------
+---- Pixel Formats ---------------------------------------------------------------------
+--------------------------------------------------------------------------------------*/
+
+// Converts a 4K image row by row, the way loadImageRGB() does, against the byte-at-a-time loops it replaced.
+static void benchmarkPixelFormat() {
+    constexpr u32 WIDTH  = 3840;
+    constexpr u32 HEIGHT = 2160;
+
+    std::vector<u8> source(WIDTH * HEIGHT * 4);
+    for (u32 i = 0; i < source.size(); i++) source[i] = static_cast<u8>((i * 2654435761u) >> 24);
+    std::vector<u8> texture(WIDTH * HEIGHT * 4), expected(WIDTH * HEIGHT * 4);
+
+    // RGB24, the old loop wrote each byte through an index & bumped the source pointer.
+    const f64 rgbLoop = timeMs(5, [&]() -> void {
+        const u8* pixel = source.data();
+        for (u32 i = 0; i < WIDTH * HEIGHT * 4; i += 4) {
+            expected[i + 0] = *pixel++;
+            expected[i + 1] = *pixel++;
+            expected[i + 2] = *pixel++;
+            expected[i + 3] = 255;
+        }
+    });
+    const f64 rgbKernel = timeMs(5, [&]() -> void {
+        for (u32 y = 0; y < HEIGHT; y++) rgb24ToRGBA(&source[y * WIDTH * 3], WIDTH, &texture[y * WIDTH * 4]);
+    });
+    const bool rgbMatch = texture == expected;
+
+    // ARGB8888, the old loop masked, shifted & 'lossed' every channel.
+    const f64 argbLoop = timeMs(5, [&]() -> void {
+        const u32* pixels = reinterpret_cast<const u32*>(source.data());
+        for (u32 i = 0; i < WIDTH * HEIGHT; i++) {
+            expected[(i * 4) + 0] = (pixels[i] & 0x00FF0000) >> 16;
+            expected[(i * 4) + 1] = (pixels[i] & 0x0000FF00) >> 8;
+            expected[(i * 4) + 2] = (pixels[i] & 0x000000FF);
+            expected[(i * 4) + 3] = (pixels[i] & 0xFF000000) >> 24;
+        }
+    });
+    const f64 argbKernel = timeMs(5, [&]() -> void {
+        for (u32 y = 0; y < HEIGHT; y++) argbToRGBA(reinterpret_cast<const u32*>(&source[y * WIDTH * 4]), WIDTH, &texture[y * WIDTH * 4]);
+    });
+    const bool argbMatch = texture == expected;
+
+    printf("kernels: %s\n", pixelFormatKernelName().data());
+    printf("%-8s %12s %12s %10s %8s\n", "format", "loop (ms)", "kernel (ms)", "speedup", "match");
+    printf("%-8s %12.3f %12.3f %9.1fx %8s\n", "RGB24", rgbLoop, rgbKernel, rgbLoop / rgbKernel, rgbMatch ? "yes" : "NO");
+    printf("%-8s %12.3f %12.3f %9.1fx %8s\n", "ARGB", argbLoop, argbKernel, argbLoop / argbKernel, argbMatch ? "yes" : "NO");
+}
+
+/*--------------------------------------------------------------------------------------
+---- Window Resizing -------------------------------------------------------------------
+--------------------------------------------------------------------------------------*/
+
+// Drags the window edge back & forth for a few hundred frames, reloading the game & the texture buffer
+// every frame, the way Framework::reloadTextures() and Game::reload() see it.
+// The baseline is the old reload: a fresh grid filled a cell at a time and a fresh texture buffer per frame.
+static void benchmarkResize() {
+    constexpr u32 FRAMES = 240;
+    auto          sizeAt = [](u32 frame, u16& width, u16& height) -> void {
+        const f64 t = 0.5 - (0.5 * std::cos(frame * 0.05));
+        width       = static_cast<u16>(1280 + (1280 * t)) & ~1;
+        height      = static_cast<u16>(720 + (720 * t)) & ~1;
+    };
+
+    printf("%-12s %16s %16s %14s\n", "scaleFactor", "baseline (ms)", "in place (ms)", "reallocs");
+    for (u8 scaleFactor : {1, 4}) {
+        u16 width, height;
+        sizeAt(0, width, height);
+
+        u64  seed = 1234567890987654321;
+        auto rand = [&]() -> u64 {
+            u64 z = (seed += UINT64_C(0x9E3779B97F4A7C15));
+            z     = (z ^ (z >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+            z     = (z ^ (z >> 27)) * UINT64_C(0x94D049BB133111EB);
+            return z ^ (z >> 31);
+        };
+        u32               cellWidth = width / scaleFactor, cellHeight = height / scaleFactor;
+        std::vector<Cell> cells(cellWidth * cellHeight);
+        std::vector<u8>   texture;
+        const f64         baseline = timeMs(FRAMES, [&, frame = 0u]() mutable -> void {
+            sizeAt(++frame, width, height);
+            const u32         newWidth = width / scaleFactor, newHeight = height / scaleFactor;
+            std::vector<Cell> newCells(newWidth * newHeight);
+            for (u32 y = 0; y < newHeight; y++)
+                for (u32 x = 0; x < newWidth; x++)
+                    if (x >= cellWidth || y >= cellHeight) newCells[(y * newWidth) + x] = Cell(false, MaterialID::EMPTY, rand() % CELL_VARIANTS, 0);
+                    else newCells[(y * newWidth) + x] = cells[(y * cellWidth) + x];
+            cells     = std::move(newCells);
+            cellWidth = newWidth, cellHeight = newHeight;
+            texture   = std::vector<u8>(width * height * 4, 255);
+        });
+
+        sizeAt(0, width, height);
+        Game game;
+        game.init(width, height, scaleFactor);
+        texture.clear();
+        texture.shrink_to_fit();
+        u32       reallocs = 0;
+        const f64 inPlace  = timeMs(FRAMES, [&, frame = 0u]() mutable -> void {
+            sizeAt(++frame, width, height);
+            game.reload(width, height, scaleFactor);
+            const size_t bytes = static_cast<size_t>(width) * height * 4;
+            if (bytes > texture.capacity()) {
+                texture.reserve(bytes + (bytes / 2));
+                reallocs++;
+            }
+            texture.assign(bytes, 255);
+        });
+        printf("%-12d %16.3f %16.3f %14u\n", scaleFactor, baseline, inPlace, reallocs);
+    }
+}
+
+/*--------------------------------------------------------------------------------------
+---- World Init ------------------------------------------------------------------------
+--------------------------------------------------------------------------------------*/
+
+// A fresh Game::init() of a 4K window, then init() again on the same Game, which reuses the memory.
+// Most of the first one is the OS faulting the pages in, compare with the memset of fresh memory.
+static void benchmarkInit() {
+    constexpr u16 WIDTH  = 3840;
+    constexpr u16 HEIGHT = 2160;
+
+    printf("%-12s %12s %16s %14s\n", "scaleFactor", "cells", "first (ms)", "again (ms)");
+    for (u8 scaleFactor : {1, 2, 4, 10}) {
+        Game      game;
+        const f64 first = timeMs(1, [&]() -> void { game.init(WIDTH, HEIGHT, scaleFactor); });
+        const f64 again = timeMs(5, [&]() -> void { game.init(WIDTH, HEIGHT, scaleFactor); });
+        printf("%-12d %5dx%-6d %16.3f %14.3f\n", scaleFactor, WIDTH / scaleFactor, HEIGHT / scaleFactor, first, again);
+    }
+
+    const size_t bytes  = static_cast<size_t>(WIDTH) * HEIGHT * sizeof(Cell);
+    u8*          fresh  = nullptr;
+    const f64    memset = timeMs(1, [&]() -> void {
+        fresh = static_cast<u8*>(std::malloc(bytes));
+        std::memset(fresh, 1, bytes);
+    });
+    const volatile u8* readBack = fresh; // or malloc + memset + free is optimised out altogether
+    printf("memset of %zu fresh MB: %.3f ms (%u)\n", bytes >> 20, memset, readBack[bytes / 2]);
+    std::free(fresh);
+}
+
+/*--------------------------------------------------------------------------------------
+---- Memory ----------------------------------------------------------------------------
+--------------------------------------------------------------------------------------*/
+
+// What a world costs, per memory tag. Each size gets a fresh Game, a minute of sand poured in
+// (so the rewind history has something in it) and is measured against the heap before it existed.
+static void benchmarkMemory() {
+    constexpr u16 SIZES[][3] = {{1280, 720, 1}, {1920, 1080, 1}, {3840, 2160, 4}, {3840, 2160, 1}};
+    constexpr u32 FRAMES     = 60;
+
+    printf("%-16s", "MB");
+    for (u8 tag = 0; tag < MemoryTag::COUNT; tag++) printf(" %14s", MemoryTag::names[tag].data());
+    printf(" %14s\n", "peak");
+
+    for (const auto& [width, height, scaleFactor] : SIZES) {
+        const MemoryStats before = memoryStats();
+        resetMemoryPeaks();
+        {
+            AppState state;
+            state.runSim           = true;
+            state.autosaveInterval = 0;
+            std::vector<u8> texture;
+            {
+                MemoryScope tag(MemoryTag::TEXTURES);
+                texture.assign(static_cast<size_t>(width) * height * 4, 255);
+            }
+
+            Game game;
+            game.init(width, height, scaleFactor);
+            for (u32 frame = 0; frame < FRAMES; frame++) {
+                game.mouseDraw((width / 4) + (frame * width / (2 * FRAMES)), height / 4, 40, 50, MaterialID::SAND, Shape::CIRCLE);
+                game.update(state, texture);
+            }
+
+            const MemoryStats after = memoryStats();
+            char              label[32];
+            snprintf(label, sizeof(label), "%ux%u /%u", width, height, scaleFactor);
+            printf("%-16s", label);
+            for (u8 tag = 0; tag < MemoryTag::COUNT; tag++) printf(" %14.2f", (after.liveBytes[tag] - before.liveBytes[tag]) / (1024.0 * 1024.0));
+            printf(" %14.2f\n", (after.totalPeak - before.totalBytes) / (1024.0 * 1024.0));
+        }
+    }
+}
+
+/*--------------------------------------------------------------------------------------
+---- Cell Layout -----------------------------------------------------------------------
+--------------------------------------------------------------------------------------*/
+
+// The same 4K world through whichever Cell this was built with, build once with & once without
+// --compact-cells to compare. A band of sand across the top falls for FRAMES frames.
+static void benchmarkCells() {
+    constexpr u16 WIDTH  = 3840;
+    constexpr u16 HEIGHT = 2160;
+    constexpr u32 FRAMES = 30;
+
+    printf("cell layout: %s, %zu bytes a cell, %u variants\n", sizeof(Cell) == 2 ? "compact" : "default", sizeof(Cell), CELL_VARIANTS);
+    printf("%-12s %12s %12s %12s %12s %12s\n", "scaleFactor", "cells (MB)", "redraw (ms)", "sim (ms)", "texture (ms)", "fill (ms)");
+    for (u8 scaleFactor : {1, 2}) {
+        AppState state;
+        state.autosaveInterval = 0;
+        state.rewindBudget     = 0;
+        std::vector<u8> texture(static_cast<size_t>(WIDTH) * HEIGHT * 4, 255);
+
+        Game game;
+        game.init(WIDTH, HEIGHT, scaleFactor);
+        game.update(state, texture);
+        const f64 cellsMB = static_cast<f64>(WIDTH / scaleFactor) * (HEIGHT / scaleFactor) * sizeof(Cell) / (1024.0 * 1024.0);
+
+        // a reset redraws the whole texture on the next update.
+        f64 redrawMs = 0;
+        for (u32 i = 0; i < 5; i++) {
+            game.reset();
+            game.update(state, texture);
+            redrawMs += state.textureMs / 5.0;
+        }
+
+        // flood fill of the whole (empty) world.
+        f64 fillMs = 0;
+        for (u32 i = 0; i < 3; i++) {
+            game.reset();
+            game.update(state, texture);
+            fillMs += timeMs(1, [&]() -> void { game.mouseDraw(WIDTH / 2, HEIGHT / 2, 1, 100, MaterialID::WATER, Shape::FILL); }) / 3.0;
+            game.endStroke();
+        }
+
+        game.reset();
+        for (u16 x = 100; x < WIDTH; x += 200) game.mouseDraw(x, HEIGHT / 6, 360, 100, MaterialID::SAND, Shape::SQUARE);
+        game.endStroke();
+        game.update(state, texture);
+        state.runSim = true;
+        f64 simMs = 0, textureMs = 0;
+        for (u32 frame = 0; frame < FRAMES; frame++) {
+            game.update(state, texture);
+            simMs += state.simMs / FRAMES;
+            textureMs += state.textureMs / FRAMES;
+        }
+        printf("%-12d %12.2f %12.3f %12.3f %12.3f %12.3f\n", scaleFactor, cellsMB, redrawMs, simMs, textureMs, fillMs);
+    }
+}
+
+/*--------------------------------------------------------------------------------------
+---- Entry Point -----------------------------------------------------------------------
+--------------------------------------------------------------------------------------*/
+
+int runBenchmarks(std::string_view filter) {
+    struct Benchmark {
+        std::string_view name;
+        void (*run)();
+    };
+    constexpr Benchmark benchmarks[] = {
+        {"brush", benchmarkBrush},
+        {"chance", benchmarkChance},
+        {"snapshot", benchmarkSnapshot},
+        {"import", benchmarkImport},
+        {"pixelformat", benchmarkPixelFormat},
+        {"resize", benchmarkResize},
+        {"init", benchmarkInit},
+        {"memory", benchmarkMemory},
+        {"cells", benchmarkCells},
+    };
+
+    bool ranAny = false;
+    for (const Benchmark& benchmark : benchmarks) {
+        if (!filter.empty() && filter != benchmark.name) continue;
+        std::cout << "[Pixel Sim] Benchmark .. " << benchmark.name << std::endl;
+        const u64 allocations = heapAllocations();
+        resetMemoryPeaks();
+        benchmark.run();
+        const MemoryStats stats = memoryStats();
+        printf("heap: peak %.2f MB, %llu allocations\n", stats.totalPeak / (1024.0 * 1024.0), static_cast<unsigned long long>(heapAllocations() - allocations));
+        std::cout << std::endl;
+        ranAny = true;
+    }
+
+    if (!ranAny) std::cout << "[Pixel Sim] No benchmark called: " << filter << std::endl;
+    return ranAny ? 0 : 1;
+}
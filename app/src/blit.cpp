@@ -0,0 +1,137 @@
+#pragma once
+#include "blit.h"
+#include "simd.h"
+#include <algorithm>
+#include <cstring>
+
+/*--------------------------------------------------------------------------------------
+---- Scalar Kernels --------------------------------------------------------------------
+--------------------------------------------------------------------------------------*/
+
+// each kernel writes a single scanline: every colour repeated 'scale' times.
+using RowKernel = void (*)(const u32* colours, u32 count, u32* dst);
+
+static void rowScaleN(const u32* colours, u32 count, u8 scale, u32* dst) {
+    for (u32 i = 0; i < count; i++) {
+        std::fill_n(dst, scale, colours[i]);
+        dst += scale;
+    }
+}
+
+static void rowScale2_Scalar(const u32* colours, u32 count, u32* dst) { rowScaleN(colours, count, 2, dst); }
+static void rowScale4_Scalar(const u32* colours, u32 count, u32* dst) { rowScaleN(colours, count, 4, dst); }
+static void rowScale8_Scalar(const u32* colours, u32 count, u32* dst) { rowScaleN(colours, count, 8, dst); }
+
+/*--------------------------------------------------------------------------------------
+---- SSE2 / AVX2 Kernels ---------------------------------------------------------------
+--------------------------------------------------------------------------------------*/
+
+#ifdef PIXEL_X86
+static void rowScale2_SSE2(const u32* colours, u32 count, u32* dst) {
+    u32 i = 0;
+    for (; i + 4 <= count; i += 4, dst += 8) { // 4 cells --> 8 texels
+        const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(colours + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 0), _mm_unpacklo_epi32(c, c));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 4), _mm_unpackhi_epi32(c, c));
+    }
+    rowScaleN(colours + i, count - i, 2, dst);
+}
+
+static void rowScale4_SSE2(const u32* colours, u32 count, u32* dst) {
+    u32 i = 0;
+    for (; i + 4 <= count; i += 4, dst += 16) { // 4 cells --> 16 texels, one broadcast per cell
+        const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(colours + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 0), _mm_shuffle_epi32(c, 0x00));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 4), _mm_shuffle_epi32(c, 0x55));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 8), _mm_shuffle_epi32(c, 0xAA));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 12), _mm_shuffle_epi32(c, 0xFF));
+    }
+    rowScaleN(colours + i, count - i, 4, dst);
+}
+
+static void rowScale8_SSE2(const u32* colours, u32 count, u32* dst) {
+    for (u32 i = 0; i < count; i++, dst += 8) {
+        const __m128i c = _mm_set1_epi32(static_cast<int>(colours[i]));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 0), c);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 4), c);
+    }
+}
+
+TARGET_AVX2 static void rowScale2_AVX2(const u32* colours, u32 count, u32* dst) {
+    const __m256i lo = _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3);
+    const __m256i hi = _mm256_setr_epi32(4, 4, 5, 5, 6, 6, 7, 7);
+
+    u32 i = 0;
+    for (; i + 8 <= count; i += 8, dst += 16) { // 8 cells --> 16 texels
+        const __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(colours + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + 0), _mm256_permutevar8x32_epi32(c, lo));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + 8), _mm256_permutevar8x32_epi32(c, hi));
+    }
+    rowScaleN(colours + i, count - i, 2, dst);
+}
+
+TARGET_AVX2 static void rowScale4_AVX2(const u32* colours, u32 count, u32* dst) {
+    const __m256i idx0 = _mm256_setr_epi32(0, 0, 0, 0, 1, 1, 1, 1);
+    const __m256i idx1 = _mm256_setr_epi32(2, 2, 2, 2, 3, 3, 3, 3);
+    const __m256i idx2 = _mm256_setr_epi32(4, 4, 4, 4, 5, 5, 5, 5);
+    const __m256i idx3 = _mm256_setr_epi32(6, 6, 6, 6, 7, 7, 7, 7);
+
+    u32 i = 0;
+    for (; i + 8 <= count; i += 8, dst += 32) { // 8 cells --> 32 texels
+        const __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(colours + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + 0), _mm256_permutevar8x32_epi32(c, idx0));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + 8), _mm256_permutevar8x32_epi32(c, idx1));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + 16), _mm256_permutevar8x32_epi32(c, idx2));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + 24), _mm256_permutevar8x32_epi32(c, idx3));
+    }
+    rowScaleN(colours + i, count - i, 4, dst);
+}
+
+TARGET_AVX2 static void rowScale8_AVX2(const u32* colours, u32 count, u32* dst) {
+    for (u32 i = 0; i < count; i++, dst += 8) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), _mm256_set1_epi32(static_cast<int>(colours[i])));
+    }
+}
+#endif
+
+/*--------------------------------------------------------------------------------------
+---- Dispatch --------------------------------------------------------------------------
+--------------------------------------------------------------------------------------*/
+
+struct BlitKernels {
+    std::string_view name;
+    RowKernel        scale2;
+    RowKernel        scale4;
+    RowKernel        scale8;
+};
+
+static const BlitKernels& blitKernels() {
+    static const BlitKernels kernels = []() -> BlitKernels {
+#ifdef PIXEL_X86
+        if (cpuFeatures().avx2) return {"AVX2", rowScale2_AVX2, rowScale4_AVX2, rowScale8_AVX2};
+        if (cpuFeatures().sse2) return {"SSE2", rowScale2_SSE2, rowScale4_SSE2, rowScale8_SSE2};
+#endif
+        return {"Scalar", rowScale2_Scalar, rowScale4_Scalar, rowScale8_Scalar};
+    }();
+    return kernels;
+}
+
+std::string_view blitKernelName() { return blitKernels().name; }
+
+void blitCellRow(const u32* colours, u32 count, u8 scaleFactor, u8* dst, u32 dstPitch) {
+    if (count == 0 || scaleFactor == 0) return;
+
+    const BlitKernels& kernels = blitKernels();
+    u32*               row     = reinterpret_cast<u32*>(dst);
+    switch (scaleFactor) {
+    case 1: std::memcpy(dst, colours, count * sizeof(u32)); break;
+    case 2: kernels.scale2(colours, count, row); break;
+    case 4: kernels.scale4(colours, count, row); break;
+    case 8: kernels.scale8(colours, count, row); break;
+    default: rowScaleN(colours, count, scaleFactor, row); break;
+    }
+
+    // every row of a cell is identical, so build it once and copy it down.
+    const size_t rowBytes = static_cast<size_t>(count) * scaleFactor * sizeof(u32);
+    for (u8 tY = 1; tY < scaleFactor; tY++) std::memcpy(dst + tY * dstPitch, dst, rowBytes);
+}
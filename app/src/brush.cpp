@@ -0,0 +1,45 @@
+#pragma once
+#include "brush.h"
+
+const BrushStamp& BrushCache::get(u8 shape, u16 size) {
+    tick++;
+    for (BrushStamp& brush : stamps)
+        if (brush.shape == shape && brush.size == size) {
+            brush.lastUsed = tick;
+            hits++;
+            return brush;
+        }
+    misses++;
+
+    BrushStamp brush;
+    brush.shape    = shape;
+    brush.size     = size;
+    brush.lastUsed = tick;
+    rasterShape(shape, 0, 0, size, [&](s32 x, s32 y, s32 length) -> void { brush.spans.push_back({x, y, length}); });
+
+    // outlines come out in octant order with overlapping corners, sort by row then merge touching runs.
+    std::sort(brush.spans.begin(), brush.spans.end(), [](const StampSpan& a, const StampSpan& b) -> bool {
+        return a.dy != b.dy ? a.dy < b.dy : a.dx < b.dx;
+    });
+    std::vector<StampSpan> merged;
+    merged.reserve(brush.spans.size());
+    for (const StampSpan& span : brush.spans) {
+        StampSpan* last = merged.empty() ? nullptr : &merged.back();
+        if (last && last->dy == span.dy && span.dx <= last->dx + last->length) last->length = std::max(last->length, span.dx + span.length - last->dx);
+        else merged.push_back(span);
+    }
+    merged.shrink_to_fit();
+    brush.spans = std::move(merged);
+
+    // evict least recently used stamps until the new one fits.
+    const u32 brushBytes = brush.spans.size() * sizeof(StampSpan);
+    while (!stamps.empty() && (stamps.size() >= MAX_STAMPS || bytes + brushBytes > MAX_BYTES)) {
+        auto oldest = std::min_element(stamps.begin(), stamps.end(), [](const BrushStamp& a, const BrushStamp& b) -> bool { return a.lastUsed < b.lastUsed; });
+        bytes -= oldest->spans.size() * sizeof(StampSpan);
+        stamps.erase(oldest);
+    }
+
+    bytes += brushBytes;
+    stamps.push_back(std::move(brush));
+    return stamps.back();
+}
@@ -0,0 +1,262 @@
+#pragma once
+#include "chunkstore.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+// the file only means something to this session, whatever's still queued is thrown away with it.
+ChunkStore::~ChunkStore() {
+    {
+        std::lock_guard guard(lock);
+        stopping = true;
+    }
+    wake.notify_one();
+    if (!worker.joinable()) return;
+    worker.join();
+    std::error_code error;
+    std::filesystem::remove(filePath, error);
+}
+
+void ChunkStore::open(const std::string& path) {
+    filePath = path;
+}
+
+void ChunkStore::clear() {
+    resident.clear();
+    uses.clear();
+    slots.clear();
+    uniforms.clear();
+    requested.clear();
+    freeSlots.clear();
+    nextSlot = 0;
+    generation++;
+    if (!worker.joinable()) return;
+    {
+        std::lock_guard guard(lock);
+        // all of them are for chunks that don't exist anymore, bar a collect() still waiting on its reads & the writes before it.
+        const auto collect = std::find_if(jobs.rbegin(), jobs.rend(), [](const Job& job) -> bool { return job.op == Job::COLLECT; });
+        jobs.erase(collect.base(), jobs.end());
+    }
+    queue({Job::TRUNCATE, 0, 0, generation, nullptr});
+}
+
+void ChunkStore::request(s32 cx, s32 cy) {
+    const u64 chunk = key(cx, cy);
+    if (auto entry = resident.find(chunk); entry != resident.end()) {
+        uses.splice(uses.begin(), uses, entry->second.use);
+        return;
+    }
+    const auto slot = slots.find(chunk);
+    if (slot == slots.end() || !requested.insert(chunk).second) return;
+    queue({Job::READ, chunk, slot->second, generation, nullptr});
+}
+
+Cell* ChunkStore::find(s32 cx, s32 cy) {
+    auto entry = resident.find(key(cx, cy));
+    if (entry == resident.end()) return nullptr;
+    uses.splice(uses.begin(), uses, entry->second.use);
+    return entry->second.cells.get();
+}
+
+bool ChunkStore::uniform(s32 cx, s32 cy, u8& material) const {
+    auto entry = uniforms.find(key(cx, cy));
+    if (entry == uniforms.end()) return false;
+    material = entry->second;
+    return true;
+}
+
+// A uniform chunk is expanded here, 'created' tells the caller to fill its cells in first, see uniform().
+Cell* ChunkStore::store(s32 cx, s32 cy, bool& created) {
+    const u64 chunk = key(cx, cy);
+    auto      entry = resident.find(chunk);
+    created         = entry == resident.end();
+    if (created) {
+        uniforms.erase(chunk);
+        MemoryScope tag(MemoryTag::CHUNKS);
+        Entry&      inserted = insert(chunk, std::make_unique_for_overwrite<Cell[]>(CHUNK_CELLS));
+        inserted.dirty       = true;
+        return inserted.cells.get();
+    }
+    uses.splice(uses.begin(), uses, entry->second.use);
+    entry->second.dirty = true;
+    return entry->second.cells.get();
+}
+
+// Whatever's queued for the old cells is harmless: a read of them is dropped in poll(), a write to the freed slot
+// lands before any write of the chunk that gets the slot next, the I/O thread goes in order.
+void ChunkStore::storeUniform(s32 cx, s32 cy, u8 material) {
+    const u64 chunk = key(cx, cy);
+    release(cx, cy);
+    requested.erase(chunk);
+    if (auto slot = slots.find(chunk); slot != slots.end()) {
+        freeSlots.push_back(slot->second);
+        slots.erase(slot);
+    }
+    MemoryScope tag(MemoryTag::CHUNKS);
+    uniforms[chunk] = material;
+}
+
+void ChunkStore::release(s32 cx, s32 cy) {
+    uniforms.erase(key(cx, cy));
+    auto entry = resident.find(key(cx, cy));
+    if (entry == resident.end()) return;
+    uses.erase(entry->second.use);
+    resident.erase(entry);
+}
+
+void ChunkStore::pin(s32 cx, s32 cy, bool pinned) {
+    auto entry = resident.find(key(cx, cy));
+    if (entry != resident.end()) entry->second.pinned = pinned;
+}
+
+void ChunkStore::poll() {
+    if (worker.joinable()) {
+        std::vector<Job> finished;
+        {
+            std::lock_guard guard(lock);
+            finished.swap(done);
+        }
+        for (Job& job : finished) {
+            if (job.generation != generation) continue;
+            const s32 cx = static_cast<s32>(job.chunk >> 32), cy = static_cast<s32>(job.chunk);
+            if (job.op == Job::WRITE) { // only failed writes come back, the chunk's gone unless it's resident again.
+                std::cout << "[Pixel Sim] Couldn't write chunk (" << cx << ", " << cy << ") to " << filePath << std::endl;
+                if (!resident.contains(job.chunk)) slots.erase(job.chunk);
+                continue;
+            }
+            if (!requested.erase(job.chunk)) continue; // went uniform since it was asked for
+            if (!job.cells) {
+                std::cout << "[Pixel Sim] Couldn't read chunk (" << cx << ", " << cy << ") from " << filePath << std::endl;
+                slots.erase(job.chunk); // comes back empty, better than blocking the window forever
+                continue;
+            }
+            reads++;
+            if (!resident.contains(job.chunk)) insert(job.chunk, std::move(job.cells));
+        }
+    }
+
+    // least recently used first, skipping the pinned ones.
+    auto use = uses.end();
+    while (residentBytes() > budget && use != uses.begin()) {
+        const u64 chunk = *--use;
+        if (resident.at(chunk).pinned) continue;
+        use = std::next(use);
+        evict(chunk);
+    }
+}
+
+std::future<std::vector<StoredChunk>> ChunkStore::collect(u8 nVariants) {
+    MemoryScope tag(MemoryTag::CHUNKS);
+    auto        collection = std::make_unique<Collection>();
+    collection->nVariants  = nVariants;
+    for (const auto& [chunk, material] : uniforms) collection->chunks.push_back({static_cast<s32>(chunk >> 32), static_cast<s32>(chunk), StoredChunk::UNIFORM, material, {}});
+    for (const auto& [chunk, slot] : slots) {
+        auto entry = resident.find(chunk);
+        if (entry == resident.end() || !entry->second.dirty) collection->slots.emplace_back(chunk, slot); // the file has it as it is
+    }
+    for (const auto& [chunk, entry] : resident) {
+        if (!entry.dirty && slots.contains(chunk)) continue;
+        auto copy = std::make_unique_for_overwrite<Cell[]>(CHUNK_CELLS);
+        std::memcpy(copy.get(), entry.cells.get(), CHUNK_BYTES);
+        collection->copied.emplace_back(chunk, std::move(copy));
+    }
+
+    auto future = collection->promise.get_future();
+    queue({Job::COLLECT, 0, 0, generation, nullptr, std::move(collection)});
+    return future;
+}
+
+ChunkStore::Entry& ChunkStore::insert(u64 chunk, std::unique_ptr<Cell[]> cells) {
+    MemoryScope tag(MemoryTag::CHUNKS);
+    uses.push_front(chunk);
+    return resident.emplace(chunk, Entry{std::move(cells), uses.begin()}).first->second;
+}
+
+// a clean chunk is already in its slot, a dirty one gets handed to the I/O thread as it is, no copy.
+void ChunkStore::evict(u64 chunk) {
+    auto entry = resident.find(chunk);
+    if (entry->second.dirty) {
+        auto [slot, fresh] = slots.try_emplace(chunk, freeSlots.empty() ? nextSlot : freeSlots.back());
+        if (fresh && freeSlots.empty()) nextSlot++;
+        else if (fresh) freeSlots.pop_back();
+        queue({Job::WRITE, chunk, slot->second, generation, std::move(entry->second.cells)});
+        writes++;
+    }
+    uses.erase(entry->second.use);
+    resident.erase(entry);
+}
+
+void ChunkStore::queue(Job&& job) {
+    if (!worker.joinable()) worker = std::thread(&ChunkStore::work, this);
+    {
+        std::lock_guard guard(lock);
+        jobs.push_back(std::move(job));
+    }
+    wake.notify_one();
+}
+
+// Runs the jobs one at a time, in order. The lock is only held to take a job & hand one back, never over the I/O.
+void ChunkStore::work() {
+    std::fstream file;
+    auto         reopen = [&]() -> void { // chunks from an earlier session mean nothing now, it always starts out empty.
+        file.close();
+        std::error_code error;
+        std::filesystem::create_directories(std::filesystem::path(filePath).parent_path(), error);
+        file.open(filePath, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+    };
+
+    std::unique_lock guard(lock);
+    while (true) {
+        wake.wait(guard, [&]() -> bool { return stopping || !jobs.empty(); });
+        if (stopping) return;
+        Job job = std::move(jobs.front());
+        jobs.pop_front();
+        guard.unlock();
+
+        if (job.op == Job::TRUNCATE || !file.is_open()) reopen();
+        const std::streamoff offset = static_cast<std::streamoff>(job.slot) * CHUNK_BYTES;
+        bool                 failed = false;
+        if (job.op == Job::READ) {
+            MemoryScope tag(MemoryTag::CHUNKS);
+            job.cells = std::make_unique_for_overwrite<Cell[]>(CHUNK_CELLS);
+            file.seekg(offset);
+            file.read(reinterpret_cast<char*>(job.cells.get()), CHUNK_BYTES);
+            if (!file) job.cells.reset();
+        } else if (job.op == Job::WRITE) {
+            file.seekp(offset);
+            file.write(reinterpret_cast<const char*>(job.cells.get()), CHUNK_BYTES);
+            failed = !file;
+            job.cells.reset();
+        } else if (job.op == Job::COLLECT) {
+            finishCollect(*job.collection, file);
+        }
+        file.clear();
+
+        guard.lock();
+        if (job.op == Job::READ || failed) done.push_back(std::move(job));
+    }
+}
+
+// the I/O thread's half of collect(), reads back the chunks only the file has & encodes the lot.
+void ChunkStore::finishCollect(Collection& collection, std::fstream& file) {
+    MemoryScope tag(MemoryTag::CHUNKS);
+    auto        encode = [&](u64 chunk, const Cell* cells) -> void {
+        StoredChunk& stored = collection.chunks.emplace_back();
+        stored.cx           = static_cast<s32>(chunk >> 32);
+        stored.cy           = static_cast<s32>(chunk);
+        encodeCells(cells, CHUNK_SIZE, CHUNK_SIZE, collection.nVariants, stored.cells);
+    };
+
+    auto cells = std::make_unique_for_overwrite<Cell[]>(CHUNK_CELLS);
+    for (const auto& [chunk, slot] : collection.slots) {
+        file.seekg(static_cast<std::streamoff>(slot) * CHUNK_BYTES);
+        file.read(reinterpret_cast<char*>(cells.get()), CHUNK_BYTES);
+        if (file) encode(chunk, cells.get());
+        else std::cout << "[Pixel Sim] Couldn't read chunk (" << static_cast<s32>(chunk >> 32) << ", " << static_cast<s32>(chunk) << ") from " << filePath << " for a snapshot" << std::endl;
+        file.clear();
+    }
+    for (const auto& [chunk, copy] : collection.copied) encode(chunk, copy.get());
+    collection.promise.set_value(std::move(collection.chunks));
+}
@@ -1,7 +1,11 @@
 #pragma once
 #include "framework.h"
+#include "pixelformat.h"
 #include <SDL_image.h>
 #include <SDL_opengl.h>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
 #include <fstream>
 #include <iostream>
 
@@ -9,10 +13,13 @@ Framework::Framework() {}
 Framework::~Framework() {}
 
 bool Framework::init(const char* title, int xpos, int ypos, int width, int height) {
+    startupStart = stageStart = std::chrono::steady_clock::now();
+    state                     = AppState();
+
     // Setup SDL
     if (SDL_Init(SDL_INIT_EVERYTHING) != 0) return false;
     if (!(IMG_Init(IMG_INIT_JPG) & IMG_INIT_JPG)) return false; // on success, returns int that the macro expands to, png == 2
-    std::cout << Message::names[Message::SDL_INIT] << std::endl;
+    logStage(Message::SDL_INIT);
 
     // GL 3.0 + GLSL 130
     const char* glsl_version = "#version 130";
@@ -20,7 +27,7 @@ bool Framework::init(const char* title, int xpos, int ypos, int width, int heigh
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 0);
-    std::cout << Message::names[Message::OPENGL_INIT] << std::endl;
+    logStage(Message::OPENGL_INIT);
 
     // Enable Native Support for Non QWERTY Input (e.g Japanese Kanji)
     SDL_SetHint(SDL_HINT_IME_SHOW_UI, "1");
@@ -38,11 +45,12 @@ bool Framework::init(const char* title, int xpos, int ypos, int width, int heigh
     SDL_GL_MakeCurrent(window, gl_context);                         // Set SDL_Window Context
     if (SDL_GL_SetSwapInterval(-1) != 0) SDL_GL_SetSwapInterval(0); // Enables Adaptive v-sync if possible, otherwise v-sync
     // SDL_GL_SetSwapInterval(0); // Disables v-sync
-    std::cout << Message::names[Message::WINDOW_INIT] << std::endl;
+    logStage(Message::WINDOW_INIT);
 
     IMGUI_CHECKVERSION();
+    ImGui::SetAllocatorFunctions([](size_t bytes, void*) -> void* { return trackedAlloc(bytes, MemoryTag::IMGUI); }, [](void* ptr, void*) -> void { trackedFree(ptr); });
     ImGui::CreateContext(); // Setup Dear ImGui context
-    std::cout << Message::names[Message::IMGUI_CONTEXT_INIT] << std::endl;
+    logStage(Message::IMGUI_CONTEXT_INIT);
 
     // |= is a bitwise operator: 0101 |= 0110 -> 0111
     ImGuiIO& io = ImGui::GetIO();                         // Setup ImGui Config
@@ -56,15 +64,6 @@ bool Framework::init(const char* title, int xpos, int ypos, int width, int heigh
     io.Fonts->AddFontFromFileTTF("../lib/fonts/Cascadia.ttf",
                                  15); // Changing Font -> Cascadia Mono (vs editor
                                       // font) | Relative paths FTW!
-    std::cout << Message::names[Message::IMGUI_CONFIG_INIT] << std::endl;
-
-    interface = new Interface();
-    if (!interface) return false;
-    std::cout << Message::names[Message::INTERFACE_INIT] << std::endl;
-
-    game = new Game();
-    if (!game) return false;
-    std::cout << Message::names[Message::GAME_INIT] << std::endl;
 
     // Setup Dear ImGui style
     ImGui::StyleColorsDark();
@@ -80,17 +79,40 @@ bool Framework::init(const char* title, int xpos, int ypos, int width, int heigh
     // Setup Platform/Renderer backends
     ImGui_ImplSDL2_InitForOpenGL(window, gl_context);
     ImGui_ImplOpenGL3_Init(glsl_version);
+    logStage(Message::IMGUI_CONFIG_INIT);
+
+    interface = new Interface();
+    if (!interface) return false;
+    logStage(Message::INTERFACE_INIT);
 
-    // Creating Textures.
-    state = AppState();
-    state.textures.push_back(TextureData(TexID::GAME, 0, 0, {}));
+    // the world exists before the first frame, sized to the window for now. The game window
+    // settles on its real size over the first frames, which is a cheap in-place reload.
+    state.textures.push_back(TextureData(TexID::GAME, width & ~1, height & ~1, {}));
     state.textures.push_back(TextureData(TexID::BACKGROUND, 0, 0, {}));
     // state.textures.push_back(TextureData(PRESENT_TEXTURE_ID   , 0, 0, {}));
+    for (TextureData& texture : state.textures) createTexture(texture);
+
+    game = new Game();
+    if (!game) return false;
+    TextureData& texture = state.textures[TexIndex::GAME];
+    game->init(texture.width, texture.height, state.scaleFactor);
+    logStage(Message::GAME_INIT);
+
+    const f32 startupMs = std::chrono::duration<f32, std::milli>(std::chrono::steady_clock::now() - startupStart).count();
+    std::cout << "[Pixel Sim]       Startup .. " << startupMs << "ms" << std::endl;
 
     applicationRunning = true;
     return true;
 }
 
+// prints a startup stage & how long it took since the last one, the debug menu shows them too.
+void Framework::logStage(u8 message) {
+    const auto now           = std::chrono::steady_clock::now();
+    state.startupMs[message] = std::chrono::duration<f32, std::milli>(now - stageStart).count();
+    stageStart               = now;
+    std::cout << Message::names[message] << " " << state.startupMs[message] << "ms" << std::endl;
+}
+
 void Framework::handleEvents() {
     SDL_Event event;
     while (SDL_PollEvent(&event)) {
@@ -101,35 +123,102 @@ void Framework::handleEvents() {
 }
 
 void Framework::update() {
+    const u64 allocations = heapAllocations(); // since the last update(), so render() & the events are in there too.
+    state.frameAllocs     = allocations - frameAllocations;
+    state.frameAllocsPeak = std::max(state.frameAllocsPeak, state.frameAllocs);
+    frameAllocations      = allocations;
+
     interface->main();
     interface->debugMenu(state);
 
-    if (ImGui::GetFrameCount() <= 2) return;
-
     ImGuiIO&     io      = ImGui::GetIO();
     TextureData& texture = state.textures[TexIndex::GAME];
 
-    if (ImGui::IsKeyPressed(ImGui::GetKeyIndex(ImGuiKey_Space))) state.runSim = !state.runSim;
-    if (io.MouseDown[0]) mouseDraw();
+    // a replay sets runSim itself, see InputOp::SIM.
+    if (ImGui::IsKeyPressed(ImGui::GetKeyIndex(ImGuiKey_Space)) && inputLog.mode() != InputLogMode::REPLAYING) state.runSim = !state.runSim;
+    if (state.stopInputLog) {
+        inputLog.stop();
+        state.stopInputLog = false;
+    }
+    if (state.startRecording) {
+        recordInputs(state.inputLogPath);
+        state.startRecording = false;
+    }
+    if (state.startReplay) {
+        replayInputs(state.inputLogPath);
+        state.startReplay = false;
+    }
+    // none can be replayed, the log would fall out of step with the world. Pans bring in chunks the log knows nothing about, see below.
+    if ((state.loadGame || state.loadImage || state.seekRewind || state.panX || state.panY) && inputLog.mode() != InputLogMode::OFF) {
+        std::cout << "[Pixel Sim] Input log stopped, loads, imports, rewinds & pans can't be replayed" << std::endl;
+        inputLog.stop();
+    }
+
+    // a replay stands in for the live drawing, resets & resizes below.
+    if (inputLog.mode() == InputLogMode::REPLAYING) {
+        replayFrame(texture);
+        state.resetSim   = false;
+        state.reloadGame = false; // the grid only changes size when the log says so
+    } else {
+        inputLog.settings(state);
+        if (io.MouseDown[0]) mouseDraw();
+        else {
+            inputLog.endStroke();
+            game->endStroke();
+            state.drawMs = 0;
+        }
+    }
     if (state.resetSim) {
         game->reset();
+        inputLog.reset();
         state.resetSim = false;
     }
     if (state.loadImage) {
         TextureData& img = state.textures[TexIndex::BACKGROUND];
-        loadImageRGB(img, state.imagePath);
-        game->loadImage(texture.data, img.data, img.width, img.height);
+        if (loadImageRGB(img, state.imagePath)) {
+            const auto start = std::chrono::steady_clock::now();
+            game->loadImage(img.data, img.width, img.height);
+            const f32 importMs = std::chrono::duration<f32, std::milli>(std::chrono::steady_clock::now() - start).count();
+            std::cout << "[Pixel Sim] Imported " << state.imagePath << " (" << img.width << "x" << img.height << ") in " << importMs << "ms" << std::endl;
+        }
         state.loadImage = false;
     }
+    if (state.saveGame) {
+        saveToFile(state.savePath);
+        state.saveGame = false;
+    }
+    if (state.loadGame) {
+        loadFromFile(state.savePath);
+        state.loadGame = false;
+    }
     if (state.reloadGame) {
         reloadTextures();
         game->reload(texture.width, texture.height, state.scaleFactor);
         state.reloadGame = false;
+        // a replay has the same chunks in its store, but not the same ones resident. Which have to be read in, & so how long
+        // the sim holds off, is down to the disk & the budget, not the log. Stopped before the resize is logged.
+        if (game->resizeUsedStore() && inputLog.mode() != InputLogMode::OFF) {
+            std::cout << "[Pixel Sim] Input log stopped, the resize uncovered chunks from the chunk store" << std::endl;
+            inputLog.stop();
+        }
+        inputLog.reload(texture.width, texture.height, state.scaleFactor);
     }
 
+    state.inputLogMode = inputLog.mode(); // the sim scheduler needs it this frame, not the last
     game->update(state, texture.data);
-
-    for (TextureData& tex : state.textures) updateTexture(tex);
+    inputLog.tick(state);
+    state.inputLogMode   = inputLog.mode();
+    state.inputLogTicks  = inputLog.tickCount();
+    state.inputLogLength = inputLog.length();
+    state.inputLogBytes  = inputLog.byteCount();
+
+    // the game texture only gets the parts Game::update() wrote, unless the GL texture was just reallocated.
+    for (TextureData& tex : state.textures)
+        if (&tex != &texture) updateTexture(tex);
+    if (texture.reallocated) updateTexture(texture);
+    else
+        for (const TexRect& rect : state.textureUploads) updateTexture(texture, rect);
+    texture.reallocated = false;
 
     interface->gameWindow(state);
 }
@@ -142,14 +231,6 @@ void Framework::render() {
     glViewport(0, 0, (int)io.DisplaySize.x, (int)io.DisplaySize.y);
     ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 
-    // Placed After ImGui::Render() to prevent ImGui HUD overwriting my textures.
-    if (ImGui::GetFrameCount() == 2) {
-        for (TextureData texture : state.textures) createTexture(texture);
-
-        TextureData& texture = state.textures[TexIndex::GAME];
-        game->init(texture.width, texture.height, state.scaleFactor);
-    }
-
     // Handles Multiple Viewports && Swaps between 2 texture buffers for smoother
     // rendering
     if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable) {
@@ -208,123 +289,152 @@ void Framework::clean() {
 //    glGenerateMipMap()
 //}
 
-//.bmp loading slanted? weird..
-// TODO: Investigate SDL_ConvertSurfaceFormat
-void Framework::loadImageRGB(TextureData& texture, std::string path) {
-    TextureData& gameTexture = state.textures[TexIndex::GAME];
+// Converts a surface row by row straight into texture.data, which keeps its capacity between loads.
+// RGB24 & ARGB8888 go through the pixel format kernels, RGBA bytes are already in texture order.
+static bool copySurface(SDL_Surface* image, TextureData& texture) {
+    const u32 format = image->format->format;
+    if (format != SDL_PIXELFORMAT_RGB24 && format != SDL_PIXELFORMAT_ARGB8888 && format != SDL_PIXELFORMAT_RGBA32) return false;
 
+    MemoryScope tag(MemoryTag::TEXTURES);
+    texture.width  = image->w;
+    texture.height = image->h;
+    texture.data.resize(static_cast<size_t>(texture.width) * texture.height * 4);
+
+    // have to lock the surface while reading it, RLE surfaces only have pixels while locked.
+    SDL_LockSurface(image);
+    for (u32 y = 0; y < texture.height; y++) {
+        const u8* row = static_cast<const u8*>(image->pixels) + (static_cast<size_t>(y) * image->pitch);
+        u8*       dst = texture.data.data() + (static_cast<size_t>(y) * texture.width * 4);
+        if (format == SDL_PIXELFORMAT_RGB24) rgb24ToRGBA(row, texture.width, dst);
+        else if (format == SDL_PIXELFORMAT_ARGB8888) argbToRGBA(reinterpret_cast<const u32*>(row), texture.width, dst);
+        else std::memcpy(dst, row, static_cast<size_t>(texture.width) * 4);
+    }
+    SDL_UnlockSurface(image);
+    return true;
+}
+
+// Loads any image SDL_image understands. Formats copySurface() can't read get converted to 'fallback' first.
+static bool loadSurface(TextureData& texture, const std::string& path, u32 fallback) {
     SDL_Surface* image = IMG_Load(path.c_str());
     if (image == NULL) {
         printf("Unable to load image %s! SDL_image Error: %s\n", path.c_str(), IMG_GetError());
-        return;
+        return false;
     }
 
-    constexpr int formatRGB24 = 386930691; // a magic number you might say. constexpr is const but better.
-    if (image->format->format != formatRGB24) {
-        image = SDL_ConvertSurfaceFormat(image, SDL_PIXELFORMAT_RGB24, 0);
-        if (image->format->format != formatRGB24) { // last chance Surface Convert.
-            std::cout << "Unable to load image Pixel Format: " << '\n';
-            std::cout << SDL_GetPixelFormatName(image->format->format) << '\n';
-            return;
+    if (!copySurface(image, texture)) {
+        SDL_Surface* converted = SDL_ConvertSurfaceFormat(image, fallback, 0);
+        if (converted == NULL || !copySurface(converted, texture)) { // last chance Surface Convert.
+            std::cout << "Unable to load image Pixel Format: " << SDL_GetPixelFormatName(image->format->format) << '\n';
+            SDL_FreeSurface(converted);
+            SDL_FreeSurface(image);
+            return false;
         }
+        SDL_FreeSurface(converted);
     }
+    SDL_FreeSurface(image);
+    return true;
+}
 
-    // have to (un)lock surface to stop SDL2 breaking
-    SDL_LockSurface(image);
-    u8* pixel = (u8*)image->pixels;
-    SDL_UnlockSurface(image);
+bool Framework::loadImageRGB(TextureData& texture, std::string path) {
+    if (!loadSurface(texture, path, SDL_PIXELFORMAT_RGB24)) return false;
+    resizeTexture(texture);
+    updateTexture(texture);
+    return true;
+}
 
-    // R | G | B | A
-    // 1 + 1 + 1 + 1 == 4 bytes
-    constexpr int bytesPerPixel = 4;
-    const int     size          = image->w * image->h * bytesPerPixel;
+bool Framework::loadImageRGBA(TextureData& texture, std::string path) {
+    if (!loadSurface(texture, path, SDL_PIXELFORMAT_ARGB8888)) return false; // 24 bit --> 32 bit
+    resizeTexture(texture);
+    updateTexture(texture);
+    return true;
+}
 
-    texture.data   = std::vector<u8>(size);
-    texture.width  = image->w;
-    texture.height = image->h;
+// Saves the world as a binary snapshot, see snapshot.h for the format.
+void Framework::saveToFile(const std::string& path) {
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
 
-    // Mapping RGB --> RGBA
-    for (int i = 0; i < size; i += 4) {
-        texture.data[i + 0] = *pixel;
-        pixel++;
-        texture.data[i + 1] = *pixel;
-        pixel++;
-        texture.data[i + 2] = *pixel;
-        pixel++;
-        texture.data[i + 3] = 255;
-    }
+    const auto start = std::chrono::steady_clock::now();
+    const bool saved = game->saveSnapshot(path, state.frame, state.saveEncoding);
+    state.snapshotMs = std::chrono::duration<f32, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (saved) std::cout << "[Pixel Sim] Saved " << path << " in " << state.snapshotMs << "ms" << std::endl;
+}
 
-    SDL_FreeSurface(image);
-    updateTexture(texture);
+void Framework::loadFromFile(const std::string& path) {
+    const auto start  = std::chrono::steady_clock::now();
+    const bool loaded = game->loadSnapshot(path, state.frame);
+    state.snapshotMs  = std::chrono::duration<f32, std::milli>(std::chrono::steady_clock::now() - start).count();
+    if (loaded) std::cout << "[Pixel Sim] Loaded " << path << " in " << state.snapshotMs << "ms" << std::endl;
 }
 
-void Framework::loadImageRGBA(TextureData& texture, std::string path) {
-    SDL_Surface* image = IMG_Load(path.c_str());
-    if (image == NULL) {
-        printf("Unable to load image %s! SDL_image Error: %s\n", path.c_str(), IMG_GetError());
+// Starts an input log with a snapshot of the world as it is now, see inputlog.h.
+void Framework::recordInputs(const std::string& path) {
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), error);
+
+    if (game->loadingWindow()) { // the snapshot would have placeholders in the window, & the sim's holding off for a while no log can say
+        std::cout << "[Pixel Sim] Can't record inputs while chunks are still being read in" << std::endl;
         return;
     }
-    image                = SDL_ConvertSurfaceFormat(image, SDL_PIXELFORMAT_RGBA8888,
-                                     0); // 24 bit --> 32 bit
-    SDL_PixelFormat* fmt = image->format;
-    std::cout << SDL_GetPixelFormatName(fmt->format) << std::endl;
-    printf("Bytes Per Pixel: %d \n", fmt->BytesPerPixel);
-
-    SDL_LockSurface(image);
-    Uint32* pixels = (Uint32*)image->pixels;
-    SDL_UnlockSurface(image);
+    game->endStroke(); // a stroke carried over from before the log would interpolate from somewhere the replay never saw.
+    if (!game->saveSnapshot(path, state.frame, SnapshotEncoding::RLE) || !inputLog.record(path, state)) return;
+    std::cout << "[Pixel Sim] Recording inputs to " << path << std::endl;
+}
 
-    texture.width  = image->w;
-    texture.height = image->h;
-    texture.data   = std::vector<GLubyte>(texture.width * texture.height * fmt->BytesPerPixel);
-    int temp       = 0;
-
-    for (int y = 0; y < texture.height; y++)
-        for (int x = 0; x < texture.width; x++) {
-            // A Uint32 is 4 bytes, so each time you step your byte offset forward by
-            // 1 pixel by incrementing x by 1, your index into the pixel data leaps
-            // forward 4 * 4 = 16 bytes:
-            u32 i     = (y * texture.width) + x;
-            u32 pixel = pixels[i];
-
-            /* Get Red component */
-            temp                = pixel & fmt->Rmask;  /* Isolate red component */
-            temp                = temp >> fmt->Rshift; /* Shift it down to 8-bit */
-            temp                = temp << fmt->Rloss;  /* Expand to a full 8-bit number */
-            texture.data[i + 0] = (Uint8)temp;
-
-            /* Get Green component */
-            temp                = pixel & fmt->Gmask;  /* Isolate green component */
-            temp                = temp >> fmt->Gshift; /* Shift it down to 8-bit */
-            temp                = temp << fmt->Gloss;  /* Expand to a full 8-bit number */
-            texture.data[i + 1] = (Uint8)temp;
-
-            /* Get Blue component */
-            temp                = pixel & fmt->Bmask;  /* Isolate blue component */
-            temp                = temp >> fmt->Bshift; /* Shift it down to 8-bit */
-            temp                = temp << fmt->Bloss;  /* Expand to a full 8-bit number */
-            texture.data[i + 2] = (Uint8)temp;
-
-            /* Get Alpha component */
-            temp                = pixel & fmt->Amask;  /* Isolate alpha component */
-            temp                = temp >> fmt->Ashift; /* Shift it down to 8-bit */
-            temp                = temp << fmt->Aloss;  /* Expand to a full 8-bit number */
-            texture.data[i + 3] = temp;
-        }
+// Restores the recorded world, then feeds the log in one frame at a time, i.e. in real time.
+// The grid is resized to the recording's first, a cropped world wouldn't play out the same.
+void Framework::replayInputs(const std::string& path) {
+    SnapshotHeader header;
+    if (!inputLog.replay(path, header)) return;
 
-    SDL_FreeSurface(image);
-    updateTexture(texture);
+    TextureData& texture = state.textures[TexIndex::GAME];
+    texture.width        = header.cellWidth * header.scaleFactor;
+    texture.height       = header.cellHeight * header.scaleFactor;
+    state.scaleFactor    = header.scaleFactor;
+    reloadTextures();
+    game->reload(texture.width, texture.height, state.scaleFactor);
+    game->endStroke();
+    if (!game->loadSnapshot(path, state.frame)) {
+        inputLog.stop();
+        return;
+    }
+    std::cout << "[Pixel Sim] Replaying " << inputLog.length() << " frames from " << path << std::endl;
 }
 
-// C:/Users/Tom/source/repos/TheCookiess/PixelPhysV2/Resources/Saves
-void Framework::saveToFile(TextureData& texture) {}
-
-void Framework::loadFromFile(TextureData& texture, std::string path) {}
+// Applies the log's inputs up to the next frame, game->update() then runs it as usual.
+void Framework::replayFrame(TextureData& texture) {
+    InputEvent event;
+    state.drawMs = 0;
+    while (inputLog.next(state, event)) {
+        switch (event.op) {
+        case InputOp::DRAW: {
+            const auto start = std::chrono::steady_clock::now();
+            game->drawAt(event.x / state.scaleFactor, event.y / state.scaleFactor, state.drawSize, state.drawChance, state.drawMaterial, state.drawShape);
+            state.drawMs += std::chrono::duration<f32, std::milli>(std::chrono::steady_clock::now() - start).count();
+        } break;
+        case InputOp::END_STROKE: game->endStroke(); break;
+        case InputOp::RESET: game->reset(); break;
+        case InputOp::RELOAD:
+            texture.width     = event.x;
+            texture.height    = event.y;
+            state.scaleFactor = event.scaleFactor;
+            reloadTextures();
+            game->reload(texture.width, texture.height, state.scaleFactor);
+            break;
+        case InputOp::TICKS: return;
+        }
+    }
+    std::cout << "[Pixel Sim] Replay finished on frame " << state.frame << std::endl;
+    inputLog.stop();
+}
 
 // Calls the openGL api to register a texture with its internal state,
 // then sets the texture parameters for the current texture target.
 void Framework::createTexture(TextureData& texture) {
-    texture.data = std::vector<GLubyte>(texture.width * texture.height * 4, 255);
+    MemoryScope tag(MemoryTag::TEXTURES);
+    texture.data           = std::vector<GLubyte>(texture.width * texture.height * 4, 255);
+    texture.capacityWidth  = texture.width;
+    texture.capacityHeight = texture.height;
 
     glGenTextures(1, &texture.id);
     glBindTexture(GL_TEXTURE_2D, texture.id);
@@ -346,12 +456,30 @@ void Framework::createTexture(TextureData& texture) {
                                        // behaviour of texture beyond regular size
 }
 
-// for each texture in the state, delete the texture and create an identical
-// one.
+// Makes sure the GL texture fits the texture's width & height. It grows by half again when outgrown,
+// so dragging the window edge doesn't reallocate every frame. Shrinking never reallocates,
+// the interface only shows the top left width x height of it.
+void Framework::resizeTexture(TextureData& texture) {
+    if (texture.width <= texture.capacityWidth && texture.height <= texture.capacityHeight) return;
+    texture.capacityWidth  = std::min<u32>(UINT16_MAX, std::max<u32>(texture.width, texture.capacityWidth + (texture.capacityWidth / 2)));
+    texture.capacityHeight = std::min<u32>(UINT16_MAX, std::max<u32>(texture.height, texture.capacityHeight + (texture.capacityHeight / 2)));
+    glBindTexture(GL_TEXTURE_2D, texture.id);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, texture.capacityWidth, texture.capacityHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    texture.reallocated = true;
+    state.texReallocCount++;
+}
+
+// for each texture in the state, resize it to its (new) width & height and clear it.
+// the data buffers grow like the GL textures do, otherwise they're reused.
+// The game texture is only resized, Game::update() moves its texels & draws whatever is new.
 void Framework::reloadTextures() {
+    MemoryScope tag(MemoryTag::TEXTURES);
     for (TextureData& texture : state.textures) {
-        glDeleteTextures(1, &texture.id);
-        createTexture(texture);
+        const size_t bytes = static_cast<size_t>(texture.width) * texture.height * 4;
+        if (bytes > texture.data.capacity()) texture.data.reserve(bytes + (bytes / 2));
+        if (&texture == &state.textures[TexIndex::GAME]) texture.data.resize(bytes, 255);
+        else texture.data.assign(bytes, 255);
+        resizeTexture(texture);
     }
     state.texReloadCount++;
 }
@@ -364,22 +492,25 @@ void Framework::updateTexture(TextureData& texture) {
                     texture.data.data()); // data.data, weird..
 }
 
-// Passes the mouse position to the game class for drawing.
-// With extra "bounds", preventing game->mouseDraw() from being called every
-// frame, reduced to every 5 frames. this is useful as the game->mouseDraw()
-// function is quite expensive to process, especially with large draw sizes and
-// complex shapes.
-void Framework::mouseDraw() {
-    ImGuiIO& io = ImGui::GetIO();
-
-    static int    lastFrameCall    = 0;
-    constexpr int minFramesTilDraw = 5;
-    if (ImGui::GetFrameCount() - lastFrameCall > minFramesTilDraw) {
-        lastFrameCall = ImGui::GetFrameCount();
-        return;
-    }
+// Uploads just 'rect', GL_UNPACK_ROW_LENGTH skips the rest of each row in texture.data.
+void Framework::updateTexture(TextureData& texture, const TexRect& rect) {
+    if (rect.width == 0 || rect.height == 0) return;
+    glBindTexture(GL_TEXTURE_2D, texture.id);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, texture.width);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, rect.x, rect.y, rect.width, rect.height, GL_RGBA, GL_UNSIGNED_BYTE,
+                    texture.data.data() + ((static_cast<size_t>(rect.y) * texture.width) + rect.x) * 4);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+}
 
+// Passes the cell under the mouse to the game class for drawing, every frame the mouse is held.
+// game->drawAt() interpolates between samples and only paints each cell once per stroke,
+// so there's no need to throttle it any more.
+void Framework::mouseDraw() {
     // Mouse pos updated in interface->debugMenu() each frame. called before
     // mouseDraw event so correct.
-    game->mouseDraw(state.mouseX, state.mouseY, state.drawSize, state.drawChance, state.drawMaterial, state.drawShape);
+    const auto start  = std::chrono::steady_clock::now();
+    const auto [x, y] = game->cellAt(state.mouseX, state.mouseY);
+    inputLog.draw(x * state.scaleFactor, y * state.scaleFactor); // where the mouse would be with the camera at rest, see InputOp::DRAW
+    game->drawAt(x, y, state.drawSize, state.drawChance, state.drawMaterial, state.drawShape);
+    state.drawMs = std::chrono::duration<f32, std::milli>(std::chrono::steady_clock::now() - start).count();
 }
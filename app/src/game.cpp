@@ -1,9 +1,21 @@
 #pragma once
 #include "game.h"
+#include "blit.h"
+#include "simd.h"
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
 
 Game::Game() {}
 Game::~Game() {}
 
+static f32 msSince(std::chrono::steady_clock::time_point start) { return std::chrono::duration<f32, std::milli>(std::chrono::steady_clock::now() - start).count(); }
+
+static constexpr u32 EMPTY_POOL = 16384; // random EMPTY cells, power of 2 (a draw is masked into it)
+static constexpr u32 EMPTY_RUN  = 64;    // cells fillEmpty() copies per draw
+
 /*--------------------------------------------------------------------------------------
 ---- State Management Functions --------------------------------------------------------
 --------------------------------------------------------------------------------------*/
@@ -15,6 +27,7 @@ void Game::init(u16 newTextureWidth, u16 newTextureHeight, u8 newScaleFactor) {
     cellWidth     = newTextureWidth / scaleFactor;
     cellHeight    = newTextureHeight / scaleFactor;
 
+    MemoryScope paletteTag(MemoryTag::PALETTE);
     // clang-format off
     materials.clear();
     materials.resize(MaterialID::COUNT); // Material(R  , G  , B  , A  , Dispersion, Density)
@@ -28,7 +41,7 @@ void Game::init(u16 newTextureWidth, u16 newTextureHeight, u8 newScaleFactor) {
     // clang-format on
 
     // generate 'nVariant' number of colour variations per material. for spice..
-    nVariants              = 20;
+    nVariants              = CELL_VARIANTS;
     constexpr u8 VARIATION = 12; // don't raise this too high, will over/underflow u8..
     for (Material &mat : materials) {
         mat.variants.clear();
@@ -47,56 +60,418 @@ void Game::init(u16 newTextureWidth, u16 newTextureHeight, u8 newScaleFactor) {
             if ((s16)mat.b - mat.variants[i][2] > VARIATION) mat.variants[i][2] = mat.b;
             if ((s16)mat.a - mat.variants[i][3] > VARIATION) mat.variants[i][3] = mat.a;
         }
-
-        cells.clear();
-        cells.reserve(cellWidth * cellHeight);
-        for (s32 i = 0; i < cellWidth * cellHeight; i++) // init cell.updated = true so updateTextureData runs on first
-                                                         // time.
-            cells.emplace_back(MaterialID::EMPTY, true, getRand<u8>(0, nVariants - 1), 0);
-        sizeChanged = true;
     }
+    buildPalette();
+    emptyCells.resize(EMPTY_POOL + EMPTY_RUN);
+    for (Cell &cell : emptyCells) cell = Cell(false, MaterialID::EMPTY, ((splitMix64_NextRand() & 0xFF) * nVariants) >> 8, 0);
+
+    cells.resize(cellWidth * cellHeight);
+    fillEmpty(cells.data(), cells.size());
+    sizeChanged = true; // the whole texture gets drawn on the first update.
+    zoom        = scaleFactor;
+    viewX       = 0;
+    viewY       = 0;
+    resetCamera = true; // & the interface's camera with it
+    textureChanges.resize(cellWidth, cellHeight);
+    strokeCoverage.resize(cellWidth, cellHeight);
+    autosave.resize(cellWidth, cellHeight);
+    rewind.resize(cellWidth, cellHeight, nVariants);
+    rewindStale  = true;
+    lastAutosave = std::chrono::steady_clock::now();
+    strokeActive = false;
+    indicatorX = UINT16_MAX; // cell coords mean something else now, rebuild the brush outline.
 }
 
-void Game::update(AppState &state, std::vector<u8> &textureData) {
-    if (state.runSim) simulate(state);
+// EMPTY cells in random variants, copied EMPTY_RUN at a time from a random spot in emptyCells.
+// A 4K world is 8M cells, even a draw per 8 cells & a table lookup per cell kept init() over 10 ms,
+// a memcpy per run goes as fast as the memory does. The pool is far too big for a repeat to show.
+void Game::fillEmpty(Cell *first, u32 count) {
+    const Cell *pool = emptyCells.data();
+    u32         i    = 0;
+    for (; i + EMPTY_RUN <= count; i += EMPTY_RUN) std::memcpy(first + i, pool + (splitMix64_NextRand() & (EMPTY_POOL - 1)), EMPTY_RUN * sizeof(Cell)); // a fixed size gets inlined
+    if (i < count) std::memcpy(first + i, pool + (splitMix64_NextRand() & (EMPTY_POOL - 1)), (count - i) * sizeof(Cell));
+}
 
-    state.textureChanges = textureChanges.size();
-    state.cellChanges    = cells.size(); // chunks.size() * CHUNK_SIZE * CHUNK_SIZE;//cells.size();
+// Cells of one material in random variants, what a uniform chunk in the ChunkStore expands into.
+void Game::fillMaterial(Cell *first, u32 count, u8 material) {
+    fillEmpty(first, count);
+    if (material != MaterialID::EMPTY)
+        for (u32 i = 0; i < count; i++) first[i].matID = material;
+}
 
-    createDrawIndicators(state.mouseX, state.mouseY, state.drawSize, state.drawShape);
+// True if a stored chunk can be kept as just its material: all one flat material with nothing in 'data'.
+// The variants are dropped, they don't show in a flat material & fillMaterial() draws them just as randomly.
+bool Game::uniformChunk(const Cell *chunk, u8 &material) const {
+    material = chunk[0].matID;
+    if (!flatMaterials[material]) return false;
+    return std::all_of(chunk, chunk + ChunkStore::CHUNK_CELLS, [&](const Cell &cell) -> bool { return cell.matID == material && !cell.data; });
+}
+
+void Game::update(AppState &state, std::vector<u8> &textureData) {
+    const u64 allocations = heapAllocations();
+    frameArena.reset(); // last update's scratch is done with
+    streamWorld(state);
+
+    rewind.setBudget(static_cast<u64>(state.rewindBudget) * 1024 * 1024, state.frame, seed);
+    if (rewindStale) {
+        rewind.clear(state.frame, seed);
+        rewindStale = false;
+    }
+    if (state.seekRewind) {
+        seekHistory(state);
+        state.seekRewind = false;
+    }
+    // cells painted or rewound since the last update, a resize or load changed too much to bother tracking.
+    if (sizeChanged || grown) {
+        chunks.rebuild(cells.data(), cellWidth, cellHeight);
+        if (!windowMoved) regions.resize(cellWidth, cellHeight);
+    } else chunks.refresh(cells.data(), textureChanges);
+    windowMoved = false;
+    applyCamera(state); // before the sim, it decides how often each chunk gets stepped
+
+    auto stageStart = std::chrono::steady_clock::now();
+    if (state.runSim && arriving.empty()) simulate(state); // held until the window's all there, see loadChunks()
+    state.simMs = msSince(stageStart);
+
+    state.textureRequests = textureChanges.markCount();
+    state.textureChanges  = textureChanges.cellCount();
+    state.cellChanges    = cells.size(); // chunks.size() * CHUNK_SIZE * CHUNK_SIZE;//cells.size();
+    state.brushCacheHits   = brushCache.hitCount();
+    state.brushCacheMisses = brushCache.missCount();
+    state.brushCacheStamps = brushCache.stampCount();
+    state.brushCacheBytes  = brushCache.byteCount();
+
+    createDrawIndicators(state.mouseX, state.mouseY, state.drawSize, state.drawShape, state.drawIndicators);
+    stageStart = std::chrono::steady_clock::now();
+    chunks.refresh(cells.data(), textureChanges); // what the sim just changed, before the texture writer clears the marks
+    regions.touch(textureChanges);
+    state.uniformChunks = chunks.uniformCount();
+    state.chunkCount    = chunks.chunkCount();
+    for (u8 tier = 0; tier < SimTier::COUNT; tier++) state.tierChunks[tier] = regions.tierCount(tier);
+    if (state.showSimTiers) {
+        MemoryScope tag(MemoryTag::CHUNKS);
+        state.simTiers.assign(regions.tierMap().begin(), regions.tierMap().end());
+        state.simTierCols = regions.colCount();
+    }
+    textureUploads.clear();
     if (sizeChanged) {
         updateEntireTextureData(textureData);
-        sizeChanged = false;
-    } else updateTextureData(textureData);
+    } else {
+        if (viewChanged) drawView(textureData); // the cells changed this frame still go through updateTextureData()
+        else if (grown) updateGrownTextureData(textureData);
+        updateTextureData(textureData);
+    }
+    sizeChanged = false;
+    viewChanged = false;
+    grown       = false;
+    state.textureUploads = textureUploads;
+    state.textureMs      = msSince(stageStart);
+
+    // after the texture writer, so every cell changed this frame has been reported to the autosave.
+    const auto now = std::chrono::steady_clock::now();
+    // not while chunks are arriving, the window only has placeholders for them. Nor while the last one's
+    // still writing, the chunks would be collected for nothing.
+    if (state.autosaveInterval > 0 && now - lastAutosave >= std::chrono::seconds(state.autosaveInterval) && arriving.empty() && !autosave.busy()) {
+        releaseMapping(state.autosavePath);
+        if (autosave.capture(cells.data(), snapshotHeader(state.frame, state.saveEncoding), state.autosavePath, world.collect(nVariants))) lastAutosave = now;
+    }
+    state.autosaveCount   = autosave.saveCount();
+    state.autosaveChunks  = autosave.chunksCopied();
+    state.autosaveTotal   = autosave.chunkCount();
+    state.autosaveStallMs = autosave.stallMs();
+    state.autosaveSaveMs  = autosave.saveMs();
+
+    rewind.commit(cells.data(), state.frame, seed);
+    state.rewindOldest    = rewind.oldest();
+    state.rewindNewest    = rewind.newest();
+    state.rewindPosition  = rewind.position();
+    state.rewindBytes     = rewind.byteCount();
+    state.rewindKeyframes = rewind.keyframeCount();
+    state.historyMs       = msSince(now);
+
+    state.arenaUsed      = frameArena.used();
+    state.arenaCapacity  = frameArena.capacity();
+    state.arenaHighWater = std::max(frameArena.highWater(), frameArena.used());
+    state.updateAllocs   = heapAllocations() - allocations;
 }
 
 void Game::reload(u16 newTextureWidth, u16 newTextureHeight, u8 newScaleFactor) {
-    const u32 newCellWidth  = newTextureWidth / newScaleFactor;
-    const u32 newCellHeight = newTextureHeight / newScaleFactor;
+    const u32 newCellWidth   = newTextureWidth / newScaleFactor;
+    const u32 newCellHeight  = newTextureHeight / newScaleFactor;
+    const u32 keepWidth      = std::min<u32>(cellWidth, newCellWidth);
+    const u32 keepHeight     = std::min<u32>(cellHeight, newCellHeight);
+    const u16 oldCellWidth   = cellWidth;
+    const u16 oldCellHeight  = cellHeight;
+    const u8  oldScaleFactor = scaleFactor;
+    storeChunks(worldX, worldY, newCellWidth, newCellHeight); // whatever the new size cuts off
+
+    // the grid is reshaped in place, a row at a time. Wider rows move towards the end of the buffer, so the
+    // last row goes first, narrower rows move towards the front, so the first row goes first.
+    if (newCellWidth * newCellHeight > cells.size()) cells.resizeKeep(newCellWidth * newCellHeight);
+    if (newCellWidth > cellWidth)
+        for (u32 y = keepHeight; y-- > 0;) std::memmove(&cells[y * newCellWidth], &cells[cellIdx(0, y)], keepWidth * sizeof(Cell));
+    else if (newCellWidth < cellWidth)
+        for (u32 y = 0; y < keepHeight; y++) std::memmove(&cells[y * newCellWidth], &cells[cellIdx(0, y)], keepWidth * sizeof(Cell));
+    cells.resizeKeep(newCellWidth * newCellHeight);
+
+    // new cells are filled in row order.
+    for (u32 y = 0; y < newCellHeight; y++) {
+        const u32 x = y < keepHeight ? keepWidth : 0;
+        fillEmpty(&cells[(y * newCellWidth) + x], newCellWidth - x);
+    }
 
-    std::vector<Cell> newCells;
-    newCells.reserve(newCellWidth * newCellHeight);
-    for (s32 y = 0; y < newCellHeight; y++)
-        for (s32 x = 0; x < newCellWidth; x++)
-            if (outOfBounds(x, y)) newCells.emplace_back(MaterialID::EMPTY, false, getRand<u8>(0, nVariants - 1), 0);
-            else newCells.push_back(cells[cellIdx(x, y)]);
+    // pure growth keeps the texture as it is, only the new strips get drawn & uploaded. Anything else redraws the lot.
+    const bool growth = !sizeChanged && newScaleFactor == scaleFactor && newTextureWidth >= textureWidth && newTextureHeight >= textureHeight;
+    if (growth && !grown) grownFrom = {viewCols(), viewRows(), textureWidth, textureHeight};
+    grown       = growth;
+    sizeChanged = !growth;
 
-    sizeChanged = true;
-
-    cells         = newCells;
     cellWidth     = newCellWidth;
     cellHeight    = newCellHeight;
     scaleFactor   = newScaleFactor;
     textureWidth  = newTextureWidth;
     textureHeight = newTextureHeight;
+    if (newScaleFactor != oldScaleFactor) { // cells are a different size now, the camera starts over. update() clamps it to the grid otherwise.
+        zoom        = scaleFactor;
+        viewX       = 0;
+        viewY       = 0;
+        resetCamera = true;
+    }
+    if (growth) textureChanges.grow(cellWidth, cellHeight); // cells drawn earlier this frame still need their texels
+    else textureChanges.resize(cellWidth, cellHeight);
+    resizeLoaded = loadChunks(worldX, worldY, oldCellWidth, oldCellHeight); // & whatever it uncovers that's been seen before
+    strokeCoverage.resize(cellWidth, cellHeight);
+    autosave.resize(cellWidth, cellHeight);
+    rewind.resize(cellWidth, cellHeight, nVariants);
+    rewindStale  = true;
+    strokeActive = false;
+    indicatorX = UINT16_MAX; // cell coords mean something else now, rebuild the brush outline.
 }
 
 void Game::reset() {
-    cells.clear();
-    cells.reserve(cellWidth * cellHeight);
+    cells.resize(cellWidth * cellHeight);
     // resetChunks();
-    for (s32 i = 0; i < cellWidth * cellHeight; i++) cells.emplace_back(MaterialID::EMPTY, false, getRand<u8>(0, nVariants - 1), 0);
+    fillEmpty(cells.data(), cells.size());
+    world.clear(); // the rest of the world goes too
+    arriving.clear();
+    strokeCoverage.clear();
     sizeChanged = true;
+    rewindStale = true;
+}
+
+// Moves the world to state.rewindTarget in the rewind history, only the cells that differ get rewritten & redrawn.
+void Game::seekHistory(AppState &state) {
+    const auto start = std::chrono::steady_clock::now();
+    rewind.commit(cells.data(), state.frame, seed); // anything drawn since the last update goes in first, so it can be undone too.
+
+    const bool keyframe = rewind.seek(state.rewindTarget, cells.data(), state.frame, seed, [&](u32 idx) -> void { textureChanges.mark(idx % cellWidth, idx / cellWidth); });
+    if (keyframe) {
+        sizeChanged = true;
+        windowMoved = false; // the whole grid's different, not just moved
+    }
+    strokeCoverage.clear();
+    strokeActive       = false;
+    state.rewindSeekMs = msSince(start);
+}
+
+/*--------------------------------------------------------------------------------------
+---- World Streaming -------------------------------------------------------------------
+--------------------------------------------------------------------------------------*/
+
+// The grid is a window onto an endless world, its top left corner sits at chunk (worldX, worldY).
+// Everything outside of it lives in the ChunkStore, see chunkstore.h. Only the window is simulated.
+
+// how many cells of chunk 'chunk' a window starting at chunk 'origin', 'length' cells long, shows. Along one axis.
+u16 Game::visibleCells(s32 chunk, s32 origin, u16 length) {
+    const s64 first = (static_cast<s64>(chunk) - origin) * ChunkStore::CHUNK_SIZE;
+    if (first < 0 || first >= length) return 0;
+    return std::min<s64>(ChunkStore::CHUNK_SIZE, length - first);
+}
+
+// Takes the pan requests, the window only moves once every chunk it's moving onto is resident. Until then
+// it stays put & the sim carries on, the chunks turn up in a later update().
+void Game::streamWorld(AppState &state) {
+    const u16 cols = (cellWidth + ChunkStore::CHUNK_SIZE - 1) / ChunkStore::CHUNK_SIZE;
+    const u16 rows = (cellHeight + ChunkStore::CHUNK_SIZE - 1) / ChunkStore::CHUNK_SIZE;
+    if (!world.isOpen()) world.open(state.chunkStorePath);
+    // never less than the window & its border twice over, or a pan could evict what it's waiting for.
+    const u64 windowBytes = static_cast<u64>(cols + 2) * (rows + 2) * ChunkStore::CHUNK_BYTES;
+    world.setBudget(std::max<u64>(static_cast<u64>(state.chunkBudget) * 1024 * 1024, 2 * windowBytes));
+    world.poll();
+
+    // chunks a resize uncovered, copied in as they turn up. The rewind history never saw them arrive.
+    for (size_t i = 0; i < arriving.size();) {
+        const auto [cx, cy] = arriving[i];
+        if (!world.ready(cx, cy)) {
+            i++;
+            continue;
+        }
+        copyChunk(cx, cy);
+        arriving[i] = arriving.back();
+        arriving.pop_back();
+        rewindStale = true;
+    }
+
+    panX += state.panX;
+    panY += state.panY;
+    state.panX = 0;
+    state.panY = 0;
+    if ((panX != worldX || panY != worldY) && arriving.empty() && requestChunks(panX, panY)) moveWindow(panX, panY);
+
+    // the border's kept coming in, so a pan by a chunk never has to wait.
+    for (s32 cx = worldX - 1; cx <= worldX + cols; cx++) {
+        world.request(cx, worldY - 1);
+        world.request(cx, worldY + rows);
+    }
+    for (s32 cy = worldY; cy < worldY + rows; cy++) {
+        world.request(worldX - 1, cy);
+        world.request(worldX + cols, cy);
+    }
+
+    state.worldX             = worldX;
+    state.worldY             = worldY;
+    state.panPending         = panX != worldX || panY != worldY || !arriving.empty();
+    state.residentChunks     = world.residentCount();
+    state.residentChunkBytes = world.residentBytes();
+    state.storedChunks       = world.storedCount();
+    state.taggedChunks       = world.uniformCount();
+    state.taggedChunkBytes   = static_cast<u64>(world.uniformCount()) * ChunkStore::CHUNK_BYTES;
+    state.loadingChunks      = world.loadingCount();
+    state.chunkReads         = world.readCount();
+    state.chunkWrites        = world.writeCount();
+}
+
+// Asks for the chunks a window at (x, y) would need loaded, returns true once they're all ready.
+bool Game::requestChunks(s32 x, s32 y) {
+    const u16 cols  = (cellWidth + ChunkStore::CHUNK_SIZE - 1) / ChunkStore::CHUNK_SIZE;
+    const u16 rows  = (cellHeight + ChunkStore::CHUNK_SIZE - 1) / ChunkStore::CHUNK_SIZE;
+    bool      ready = true;
+    for (s32 cy = y; cy < y + rows; cy++)
+        for (s32 cx = x; cx < x + cols; cx++) {
+            if (visibleCells(cx, worldX, cellWidth) && visibleCells(cy, worldY, cellHeight)) continue; // in the window now, it's stored on the way
+            if (world.ready(cx, cy)) continue;
+            world.request(cx, cy);
+            ready = false;
+        }
+    return ready;
+}
+
+// Stores the window's chunks that a window at (x, y), width x height cells, wouldn't show the same.
+void Game::storeChunks(s32 x, s32 y, u16 width, u16 height) {
+    const u16 cols = (cellWidth + ChunkStore::CHUNK_SIZE - 1) / ChunkStore::CHUNK_SIZE;
+    const u16 rows = (cellHeight + ChunkStore::CHUNK_SIZE - 1) / ChunkStore::CHUNK_SIZE;
+    for (u16 row = 0; row < rows; row++)
+        for (u16 col = 0; col < cols; col++) {
+            const s32 cx = worldX + col, cy = worldY + row;
+            const u16 w = visibleCells(cx, worldX, cellWidth), h = visibleCells(cy, worldY, cellHeight);
+            const u16 newW = visibleCells(cx, x, width), newH = visibleCells(cy, y, height);
+            if (newW == w && newH == h) continue;
+            if (newW >= w && newH >= h && !world.known(cx, cy)) continue; // none of it leaves the window, & there's nothing outside it to keep
+            if (std::ranges::find(arriving, std::pair(cx, cy)) != arriving.end()) continue; // the window only has placeholders, the store has the real thing
+            storeChunk(cx, cy, &cells[cellIdx(col * ChunkStore::CHUNK_SIZE, row * ChunkStore::CHUNK_SIZE)], cellWidth, w, h);
+        }
+}
+
+// the w x h corner of the chunk that's in a grid 'pitch' cells wide, the rest of it stays as it was.
+void Game::storeChunk(s32 cx, s32 cy, const Cell* src, u32 pitch, u16 w, u16 h) {
+    bool  created;
+    u8    material = MaterialID::EMPTY; // never seen, empty like anywhere new
+    world.uniform(cx, cy, material);
+    Cell *chunk = world.store(cx, cy, created);
+    if (created && (w < ChunkStore::CHUNK_SIZE || h < ChunkStore::CHUNK_SIZE)) fillMaterial(chunk, ChunkStore::CHUNK_CELLS, material); // the rest of it
+    for (u16 i = 0; i < h; i++) std::memcpy(&chunk[i * ChunkStore::CHUNK_SIZE], &src[static_cast<size_t>(i) * pitch], w * sizeof(Cell));
+    if (uniformChunk(chunk, material)) world.storeUniform(cx, cy, material); // no cells or file slot for it
+    else world.pin(cx, cy, false);
+}
+
+// Loads the window's chunks that a window at (x, y), width x height cells, didn't show the same. Cells new
+// to the window have to be filled in already, the chunks that were never stored are left as they are.
+// A pan has them all by now. A resize can uncover ones that aren't, those stay as they are until they're
+// read in, see streamWorld(). Nothing waits on the disk.
+// Returns true if any of them show more of themselves than before, i.e. the store decides what's there.
+bool Game::loadChunks(s32 x, s32 y, u16 width, u16 height) {
+    const u16 cols   = (cellWidth + ChunkStore::CHUNK_SIZE - 1) / ChunkStore::CHUNK_SIZE;
+    const u16 rows   = (cellHeight + ChunkStore::CHUNK_SIZE - 1) / ChunkStore::CHUNK_SIZE;
+    bool      loaded = false;
+    for (u16 row = 0; row < rows; row++)
+        for (u16 col = 0; col < cols; col++) {
+            const s32 cx = worldX + col, cy = worldY + row;
+            if (visibleCells(cx, x, width) == visibleCells(cx, worldX, cellWidth) && visibleCells(cy, y, height) == visibleCells(cy, worldY, cellHeight)) continue;
+            if (!world.known(cx, cy)) continue;
+            loaded |= visibleCells(cx, worldX, cellWidth) > visibleCells(cx, x, width) || visibleCells(cy, worldY, cellHeight) > visibleCells(cy, y, height);
+            if (world.ready(cx, cy)) copyChunk(cx, cy);
+            else if (std::ranges::find(arriving, std::pair(cx, cy)) == arriving.end()) {
+                world.request(cx, cy);
+                arriving.emplace_back(cx, cy);
+            }
+        }
+    return loaded;
+}
+
+// Copies the part of a resident or uniform chunk the window shows into the grid & marks it for drawing.
+void Game::copyChunk(s32 cx, s32 cy) {
+    const u16 w = visibleCells(cx, worldX, cellWidth), h = visibleCells(cy, worldY, cellHeight);
+    if (!w || !h) return; // a resize since took it out of the window again, it stays in the store
+    const u16 x0 = (cx - worldX) * ChunkStore::CHUNK_SIZE, y0 = (cy - worldY) * ChunkStore::CHUNK_SIZE;
+    u8        material;
+    if (world.uniform(cx, cy, material)) {
+        for (u16 i = 0; i < h; i++) {
+            fillMaterial(&cells[cellIdx(x0, y0 + i)], w, material);
+            textureChanges.markRun(x0, y0 + i, w);
+        }
+        if (w == ChunkStore::CHUNK_SIZE && h == ChunkStore::CHUNK_SIZE) world.release(cx, cy); // the part outside the window stays a tag, nothing to pin
+        return;
+    }
+    const Cell *chunk = world.find(cx, cy);
+    if (!chunk) return; // couldn't be read, it's empty now
+    for (u16 i = 0; i < h; i++) {
+        std::memcpy(&cells[cellIdx(x0, y0 + i)], &chunk[i * ChunkStore::CHUNK_SIZE], w * sizeof(Cell));
+        textureChanges.markRun(x0, y0 + i, w);
+    }
+    if (w < ChunkStore::CHUNK_SIZE || h < ChunkStore::CHUNK_SIZE) world.pin(cx, cy, true); // the part outside the window only lives in there
+    else world.release(cx, cy);                                                        // the grid has all of it
+}
+
+// Moves the window to (x, y), its chunks have to be ready, see requestChunks(). Cells in both the old &
+// the new window are moved over a row at a time, like reload() does, the rest get filled in & loaded.
+void Game::moveWindow(s32 x, s32 y) {
+    const s32 oldX = worldX, oldY = worldY;
+    storeChunks(x, y, cellWidth, cellHeight);
+
+    const s64 dx = static_cast<s64>(x - oldX) * ChunkStore::CHUNK_SIZE; // row 'y' comes from row y + dy, & so on
+    const s64 dy = static_cast<s64>(y - oldY) * ChunkStore::CHUNK_SIZE;
+    const u16 x0 = std::clamp<s64>(-dx, 0, cellWidth);
+    const u16 x1 = std::clamp<s64>(cellWidth - dx, 0, cellWidth);
+    auto      moveRow = [&](u16 row) -> void {
+        const s64 from = row + dy;
+        if (from < 0 || from >= cellHeight || x0 >= x1) {
+            fillEmpty(&cells[cellIdx(0, row)], cellWidth);
+            return;
+        }
+        std::memmove(&cells[cellIdx(x0, row)], &cells[cellIdx(x0 + dx, from)], (x1 - x0) * sizeof(Cell));
+        fillEmpty(&cells[cellIdx(0, row)], x0);
+        fillEmpty(&cells[cellIdx(x1, row)], cellWidth - x1);
+    };
+    // rows coming from further down move up, so the first goes first. Rows coming from further up go last first.
+    if (dy > 0)
+        for (u16 row = 0; row < cellHeight; row++) moveRow(row);
+    else
+        for (u16 row = cellHeight; row-- > 0;) moveRow(row);
+
+    worldX = x;
+    worldY = y;
+    loadChunks(oldX, oldY, cellWidth, cellHeight);
+    if (!sizeChanged && !grown) { // otherwise it's rebuilt this update anyway
+        regions.shift(x - oldX, y - oldY);
+        windowMoved = true;
+    }
+
+    sizeChanged = true; // everything's moved, redraw the lot
+    textureChanges.clear();
+    strokeCoverage.clear();
+    strokeActive = false;
+    autosave.markAll();
+    rewindStale = true; // the history's of cells that aren't where they were anymore
 }
 
 /*--------------------------------------------------------------------------------------
@@ -104,12 +479,18 @@ void Game::reset() {
 --------------------------------------------------------------------------------------*/
 
 void Game::simulate(AppState &state) {
+    MemoryScope tag(MemoryTag::CHANGE_LISTS); // cells changed this frame, for the rewind history
     // keep some form of global index that is incremented with each cell
     // thereby eliminating the need to pass x,y to cellUpdate etc. instead just
     // cell.
 
     fluidDispersionFactor = state.fluidDispersionFactor;
     solidDispersionFactor = state.solidDispersionFactor;
+    skipUniform           = state.skipUniformChunks;
+
+    // an input log has no camera in it, the whole grid's stepped every frame while one's recording or replaying.
+    const bool lod = state.simLod && state.inputLogMode == InputLogMode::OFF;
+    regions.plan(state.frame, viewX, viewY, viewCols(), viewRows(), state.lodNearChunks, state.lodInterval, lod);
 
     switch (state.scanMode) {
     case Scan::BOTTOM_UP_LEFT: l_bottomUpUpdate(); break;
@@ -131,36 +512,44 @@ void Game::simulate(AppState &state) {
 }
 
 void Game::l_bottomUpUpdate() {
-    for (s32 y = cellHeight - 1; y >= 0; y--)
-        for (s32 x = 0; x < cellWidth; x++) {
-            updateCell(x, y);
-        }
+    for (s32 y = cellHeight - 1; y >= 0; y--) updateRow(y, true);
 }
 
 void Game::r_bottomUpUpdate() {
-    for (s32 y = cellHeight - 1; y >= 0; y--)
-        for (s32 x = cellWidth - 1; x >= 0; x--) {
-            updateCell(x, y);
-        }
+    for (s32 y = cellHeight - 1; y >= 0; y--) updateRow(y, false);
 }
 
 void Game::snakeUpdate() {
-    for (s32 y = cellHeight - 1; y >= 0; y--)
-        if ((cellHeight - y) % 2 == 0) // -->
-            for (s32 x = 0; x < cellWidth; x++) {
-                updateCell(x, y);
-            }
-        else // <--
-            for (s32 x = cellWidth - 1; x >= 0; x--) {
-                updateCell(x, y);
-            }
+    for (s32 y = cellHeight - 1; y >= 0; y--) updateRow(y, (cellHeight - y) % 2 == 0); // --> on even rows, <-- on odd
+}
+
+// Updates row y a chunk at a time, chunks that are all one inert material are skipped, updateCell() wouldn't
+// do anything to them anyway. Anything that moves into one this frame is marked updated, so skipping it is
+// exactly the same as visiting it, the ChunkMap catches up before the next frame.
+// Chunks the RegionScheduler hasn't got down for this frame are skipped too, that one's not exact.
+void Game::updateRow(u16 y, bool leftToRight) {
+    const u16 cols = chunks.colCount();
+    const u16 cy   = y / ChunkMap::CHUNK_SIZE;
+    for (u16 i = 0; i < cols; i++) {
+        const u16 cx = leftToRight ? i : cols - 1 - i;
+        if (skipUniform && inert(chunks.material(cx, cy))) continue;
+        dispersionScale = regions.step(cx, cy);
+        if (!dispersionScale) continue;
+
+        const s32 x0 = cx * ChunkMap::CHUNK_SIZE;
+        const s32 x1 = std::min<s32>(x0 + ChunkMap::CHUNK_SIZE, cellWidth);
+        if (leftToRight)
+            for (s32 x = x0; x < x1; x++) updateCell(x, y);
+        else
+            for (s32 x = x1 - 1; x >= x0; x--) updateCell(x, y);
+    }
 }
 
 void Game::golUpdate() {
-    std::vector<std::pair<Cell, std::pair<u16, u16>>> updatedCells;
-    auto                                              updateCellLambda = [&](u16 x, u16 y, u8 matID, u8 variant) -> void {
-        updatedCells.emplace_back(Cell(true, matID, variant, 0), std::pair<u16, u16>(x, y));
-        textureChanges.push_back(std::pair<u16, u16>(x, y));
+    ArenaVector<std::pair<u32, Cell>> updatedCells(frameArena);
+    auto                              updateCellLambda = [&](u16 x, u16 y, u8 matID, u8 variant) -> void {
+        updatedCells.emplace_back(cellIdx(x, y), Cell(true, matID, variant, 0));
+        textureChanges.mark(x, y);
     };
 
     for (u16 y = 1; y < cellHeight - 2; y++)
@@ -183,7 +572,10 @@ void Game::golUpdate() {
                 updateCellLambda(x, y, MaterialID::GOL_ALIVE, c.variant);
             }
         }
-    for (auto &[cell, coords] : updatedCells) cells[cellIdx(coords.first, coords.second)] = cell;
+    for (const auto &[idx, cell] : updatedCells) {
+        recordChange(idx);
+        cells[idx] = cell;
+    }
 }
 
 /*--------------------------------------------------------------------------------------
@@ -215,7 +607,7 @@ bool Game::updateCell(u16 x, u16 y) {
 bool Game::updateSand(u16 x, u16 y) {
     s8 yDispersion = 0;
     s8 xDispersion = 0;
-    s8 movesLeft   = solidDispersionFactor;
+    s8 movesLeft   = dispersion(solidDispersionFactor);
 
     while (movesLeft > 0) {
         if (querySwap(x, y, x + xDispersion,
@@ -241,7 +633,7 @@ bool Game::updateSand(u16 x, u16 y) {
 bool Game::updateWater(u16 x, u16 y) {
     s8 yDispersion = 0;
     s8 xDispersion = 0;
-    s8 movesLeft   = fluidDispersionFactor;
+    s8 movesLeft   = dispersion(fluidDispersionFactor);
 
     while (movesLeft > 0) {
         // check for empty space below..
@@ -279,7 +671,7 @@ ESCAPE_WHILE_WATER:
 bool Game::updateNaturalGas(u16 x, u16 y) {
     s8 yDispersion = 0;
     s8 xDispersion = 0;
-    s8 movesLeft   = 4;
+    s8 movesLeft   = dispersion(4);
 
     while (movesLeft > 0) {
         if (querySwapAbove(x, y, x + xDispersion,
@@ -333,14 +725,19 @@ bool Game::querySwap(u16 x1, u16 y1, u16 x2, u16 y2) {
 
 void Game::changeMaterial(u16 x, u16 y, u8 newMaterial) {
     if (outOfBounds(x, y)) return; // not consistent control flow, but it works.
+    recordChange(cellIdx(x, y));
     Cell &c   = cells[cellIdx(x, y)];
     c.matID   = newMaterial;
     c.updated = true;
 
-    textureChanges.push_back(std::pair<u16, u16>(x, y));
+    textureChanges.mark(x, y);
 }
 
 void Game::swapCells(u16 x1, u16 y1, u16 x2, u16 y2) {
+    // a cell that stays put changes nothing. Marking it would keep settled chunks awake, see RegionScheduler::touch().
+    if (x1 == x2 && y1 == y2) return;
+    recordChange(cellIdx(x1, y1));
+    recordChange(cellIdx(x2, y2));
     Cell &c1 = cells[cellIdx(x1, y1)];
     Cell &c2 = cells[cellIdx(x2, y2)];
 
@@ -351,330 +748,616 @@ void Game::swapCells(u16 x1, u16 y1, u16 x2, u16 y2) {
     c1.updated = true;
     c2.updated = true;
 
-    textureChanges.push_back(std::pair<u16, u16>(x1, y1));
-    textureChanges.push_back(std::pair<u16, u16>(x2, y2));
+    textureChanges.mark(x1, y1);
+    textureChanges.mark(x2, y2);
+}
+
+/*--------------------------------------------------------------------------------------
+---- Camera ----------------------------------------------------------------------------
+--------------------------------------------------------------------------------------*/
+
+// Takes the camera the interface asked for, clamped so the view never runs off the grid. The clamped
+// camera is written back, so the interface always shows (and keeps adjusting) what's actually drawn.
+void Game::applyCamera(AppState &state) {
+    if (resetCamera) {
+        state.zoom  = 0;
+        state.viewX = 0;
+        state.viewY = 0;
+        resetCamera = false;
+    }
+    const u8  newZoom  = std::clamp<u8>(state.zoom ? state.zoom : scaleFactor, 1, AppState::MAX_ZOOM);
+    const s32 newViewX = std::clamp<s32>(state.viewX, 0, std::max(0, cellWidth - (textureWidth / newZoom)));
+    const s32 newViewY = std::clamp<s32>(state.viewY, 0, std::max(0, cellHeight - (textureHeight / newZoom)));
+    if (newZoom != zoom || newViewX != viewX || newViewY != viewY) {
+        zoom        = newZoom;
+        viewX       = newViewX;
+        viewY       = newViewY;
+        viewChanged = true;
+        indicatorX  = UINT16_MAX; // same cell, different place on screen
+    }
+    state.zoom         = zoom;
+    state.viewX        = viewX;
+    state.viewY        = viewY;
+    state.visibleCells = viewCols() * viewRows();
+}
+
+std::pair<u16, u16> Game::cellAt(u16 mx, u16 my) const {
+    const u16 x = mx / zoom, y = my / zoom;
+    return {x < viewCols() ? viewX + x : cellWidth, y < viewRows() ? viewY + y : cellHeight};
 }
 
 /*--------------------------------------------------------------------------------------
 ---- Mouse Functions -------------------------------------------------------------------
 --------------------------------------------------------------------------------------*/
 
-void Game::createDrawIndicators(u16 mx, u16 my, u16 size, u8 shape) {
-    auto boundedPushBack = [&](u16 x,
-                               u16 y,
-                               u8  mat = 0) -> void { // need a 3rd param for consistency.
-        if (!outOfBounds(x, y)) drawIndicators.push_back(std::pair<u16, u16>(x, y));
-    };
+// Builds the brush outline drawn over the game window, see Interface::gameWindow().
+// It never touches the game texture, so moving the mouse doesn't dirty any cells.
+// The outline is clipped to the view & relative to its top left corner.
+void Game::createDrawIndicators(u16 mx, u16 my, u16 size, u8 shape, std::vector<std::pair<u16, u16>> &indicators) {
+    const auto [x, y] = cellAt(mx, my);
 
-    const u32 x = mx / scaleFactor;
-    const u32 y = my / scaleFactor;
+    if (x == indicatorX && y == indicatorY && size == indicatorSize && shape == indicatorShape) return;
+    indicatorX     = x;
+    indicatorY     = y;
+    indicatorSize  = size;
+    indicatorShape = shape;
 
+    indicators.clear();
     if (outOfBounds(x, y)) return;
-
-    switch (shape) {
-    case Shape::CIRCLE:
-    case Shape::CIRCLE_OUTLINE: drawCircleOutline(x, y, size, 0, 100, boundedPushBack); break;
-    case Shape::LINE: drawLine(x, y, size, 0, 100, boundedPushBack); break;
-    case Shape::SQUARE:
-    case Shape::SQUARE_OUTLINE: drawSquareOutline(x, y, size, 0, 100, boundedPushBack); break;
+    if (shape == Shape::FILL) {
+        indicators.push_back(std::pair<u16, u16>(x - viewX, y - viewY));
+        return;
     }
+
+    const s32 cols = viewCols(), rows = viewRows();
+    auto      pushSpan = [&](s32 x, s32 y, s32 length) -> void {
+        if (y < viewY || y >= viewY + rows) return;
+        const s32 from = std::max<s32>(x, viewX), to = std::min<s32>(x + length, viewX + cols);
+        for (s32 i = from; i < to; i++) indicators.push_back(std::pair<u16, u16>(i - viewX, y - viewY));
+    };
+
+    u8 outline = shape;
+    if (shape == Shape::CIRCLE) outline = Shape::CIRCLE_OUTLINE;
+    if (shape == Shape::SQUARE) outline = Shape::SQUARE_OUTLINE;
+    BrushCache::stamp(brushCache.get(outline, size), x, y, cellWidth, cellHeight, pushSpan);
 }
 
 void Game::mouseDraw(u16 mx, u16 my, u16 size, u8 drawChance, u8 material, u8 shape) {
-    const u32 x = mx / scaleFactor;
-    const u32 y = my / scaleFactor;
+    const auto [x, y] = cellAt(mx, my);
+    drawAt(x, y, size, drawChance, material, shape);
+}
 
-    if (outOfBounds(x, y)) return;
+// Called every frame the mouse is held down. Stamps the brush along the segment from the last
+// sample to this one, so fast strokes don't leave gaps. Every stamp is unioned into strokeCoverage,
+// a cell covered by several overlapping stamps is only rolled against drawChance (and painted) once per stroke.
+void Game::drawAt(u16 x, u16 y, u16 size, u8 drawChance, u8 material, u8 shape) {
+    MemoryScope tag(MemoryTag::CHANGE_LISTS);
+    if (outOfBounds(x, y)) {
+        strokeActive = false; // left the grid, start a fresh segment when the mouse comes back.
+        return;
+    }
 
-    auto changeMaterialLambda = [&](u16 x, u16 y, u8 material) -> void { changeMaterial(x, y, material); };
-    switch (shape) {
-    case Shape::CIRCLE: drawCircle(x, y, size, material, drawChance, changeMaterialLambda); break;
-    case Shape::CIRCLE_OUTLINE: drawCircleOutline(x, y, size, material, drawChance, changeMaterialLambda); break;
-    case Shape::LINE: drawLine(x, y, size, material, drawChance, changeMaterialLambda); break;
-    case Shape::SQUARE: drawSquare(x, y, size, material, drawChance, changeMaterialLambda); break;
-    case Shape::SQUARE_OUTLINE: drawSquareOutline(x, y, size, material, drawChance, changeMaterialLambda); break;
+    if (chanceSampler.chance() != drawChance) chanceSampler = ChanceSampler(drawChance);
+    if (shape == Shape::FILL) {
+        floodFill(x, y, material);
+        strokeActive = true;
+        return;
     }
-}
 
-void Game::drawCircle(u16 x, u16 y, u16 size, u8 material, u8 drawChance, std::function<void(u16, u16, u8)> foo) {
-    int r2   = size * size;
-    int area = r2 << 2;
-    int rr   = size << 1;
+    u64  gap       = chanceSampler.nextGap([&]() -> u64 { return splitMix64_NextRand(); });
+    auto paintSpan = [&](s32 x, s32 y, s32 length) -> void { paintRun(x, y, length, material, gap); };
+    const BrushStamp &brush = brushCache.get(shape, size);
+    auto              stamp = [&](u16 x, u16 y) -> void { BrushCache::stamp(brush, x, y, cellWidth, cellHeight, paintSpan); };
+
+    if (!strokeActive) stamp(x, y);
+    else {
+        // filled shapes can be spaced out a bit without leaving holes, outlines and lines can't.
+        const bool filled   = shape == Shape::CIRCLE || shape == Shape::SQUARE;
+        const s32  spacing  = filled ? std::max(1, size / 4) : 1;
+        const s32  dX       = x - strokeX;
+        const s32  dY       = y - strokeY;
+        const s32  distance = std::max(std::abs(dX), std::abs(dY));
+        const s32  steps    = (distance + spacing - 1) / spacing;
+        for (s32 i = 1; i <= steps; i++) // i == 0 is the previous sample, already stamped.
+            stamp(strokeX + (dX * i) / steps, strokeY + (dY * i) / steps);
+    }
 
-    for (s32 i = 0; i < area; i++) {
-        int tX = (i % rr) - size;
-        int tY = (i / rr) - size;
+    strokeActive = true;
+    strokeX      = x;
+    strokeY      = y;
+}
 
-        if (tX * tX + tY * tY <= r2)
-            if (getRand<s64>(1, 100) <= drawChance) foo(x + tX, y + tY, material);
-    }
+// Paints the cells in a run that this stroke hasn't covered yet. strokeCoverage hands them back a word at a time,
+// chanceSampler then jumps straight to the ones that pass drawChance. 'gap' carries over between runs.
+void Game::paintRun(u16 x, u16 y, u16 length, u8 material, u64 &gap) {
+    Cell *row  = &cells[cellIdx(0, y)];
+    auto  rand = [&]() -> u64 { return splitMix64_NextRand(); };
+    strokeCoverage.markRun(x, y, length, [&](u16 baseX, u16 y, u64 fresh) -> void {
+        if (fresh == ~u64(0) && chanceSampler.chance() >= 100) { // a whole word gets painted, do it in bulk.
+            for (u16 i = baseX; i < baseX + 64; i++) {
+                recordChange(cellIdx(i, y));
+                row[i].matID   = material;
+                row[i].updated = true;
+            }
+            textureChanges.markRun(baseX, y, 64);
+            return;
+        }
+        const u64 painted = chanceSampler.sampleBits(fresh, gap, rand);
+        for (u64 bits = painted; bits; bits &= bits - 1) {
+            recordChange(cellIdx(baseX + std::countr_zero(bits), y));
+            Cell &c   = row[baseX + std::countr_zero(bits)];
+            c.matID   = material;
+            c.updated = true;
+        }
+        textureChanges.markBits(baseX, y, painted);
+    });
 }
 
-void Game::drawCircleOutline(u16 x, u16 y, u16 size, u8 material, u8 drawChance, std::function<void(u16, u16, u8)> foo) {
-    auto drawCircleSegments = [&](u16 xc, u16 yc, u16 x, u16 y, u8 material) -> void {
-        foo(xc + x, yc + y, material);
-        foo(xc - x, yc + y, material);
-        foo(xc + x, yc - y, material);
-        foo(xc - x, yc - y, material);
-        foo(xc + y, yc + x, material);
-        foo(xc - y, yc + x, material);
-        foo(xc + y, yc - x, material);
-        foo(xc - y, yc - x, material);
-    };
+// bit i set if cells[i].matID == matID, count <= 64.
+static u64 matchMaterial_Scalar(const Cell *cells, u32 count, u8 matID) {
+    u64 mask = 0;
+    for (u32 i = 0; i < count; i++) mask |= u64(cells[i].matID == matID) << i;
+    return mask;
+}
+
+#if defined(PIXEL_X86) && defined(PIXEL_COMPACT_CELLS)
+static_assert(sizeof(Cell) == 2, "matchMaterial assumes a 2 byte cell");
+
+// bitfield order is up to the compiler, & a constexpr bit_cast of one isn't portable, so it's checked once at runtime.
+static bool matIDInLowBits() {
+    const Cell probe(false, 0x1F, 0, 0);
+    u16        bits;
+    std::memcpy(&bits, &probe, sizeof(bits));
+    return bits == 0x1F;
+}
 
-    s32 tX = 0;
-    s32 tY = size;
-    s32 d  = 3 - 2 * size;
-    drawCircleSegments(x, y, tX, tY, material);
-    while (tY >= tX) {
-        tX++;
-        if (d > 0) {
-            tY--;
-            d = d + 4 * (tX - tY) + 10;
-        } else d = d + 4 * tX + 6;
-        drawCircleSegments(x, y, tX, tY, material);
+static u64 matchMaterial_SSE2(const Cell *cells, u32 count, u8 matID) {
+    const __m128i keep = _mm_set1_epi16(0x1F);
+    const __m128i want = _mm_set1_epi16(matID);
+    u64           mask = 0;
+    u32           i    = 0;
+    for (; i + 8 <= count; i += 8) { // 8 cells per compare, packed down to a byte each for the movemask
+        const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(cells + i));
+        const __m128i e = _mm_cmpeq_epi16(_mm_and_si128(c, keep), want);
+        mask |= u64(_mm_movemask_epi8(_mm_packs_epi16(e, e)) & 0xFF) << i;
     }
+    return mask | (i < count ? matchMaterial_Scalar(cells + i, count - i, matID) << i : 0);
+}
+#elif defined(PIXEL_X86)
+static_assert(sizeof(Cell) == 4 && offsetof(Cell, matID) == 1, "matchMaterial assumes matID is byte 1 of a 4 byte cell");
+
+static u64 matchMaterial_SSE2(const Cell *cells, u32 count, u8 matID) {
+    const __m128i keep = _mm_set1_epi32(0xFF00);
+    const __m128i want = _mm_set1_epi32(matID << 8);
+    u64           mask = 0;
+    u32           i    = 0;
+    for (; i + 4 <= count; i += 4) { // 4 cells per compare
+        const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(cells + i));
+        const __m128i e = _mm_cmpeq_epi32(_mm_and_si128(c, keep), want);
+        mask |= u64(_mm_movemask_ps(_mm_castsi128_ps(e))) << i;
+    }
+    return mask | (i < count ? matchMaterial_Scalar(cells + i, count - i, matID) << i : 0);
 }
 
-void Game::drawLine(u16 x, u16 y, u16 size, u8 material, u8 drawChance, std::function<void(u16, u16, u8)> foo) {
-    for (s32 tX = -size; tX < size; tX++)
-        if (getRand<s64>(1, 100) <= drawChance) foo(x + tX, y, material);
+TARGET_AVX2 static u64 matchMaterial_AVX2(const Cell *cells, u32 count, u8 matID) {
+    const __m256i keep = _mm256_set1_epi32(0xFF00);
+    const __m256i want = _mm256_set1_epi32(matID << 8);
+    u64           mask = 0;
+    u32           i    = 0;
+    for (; i + 8 <= count; i += 8) { // 8 cells per compare
+        const __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(cells + i));
+        const __m256i e = _mm256_cmpeq_epi32(_mm256_and_si256(c, keep), want);
+        mask |= u64(_mm256_movemask_ps(_mm256_castsi256_ps(e))) << i;
+    }
+    return mask | (i < count ? matchMaterial_Scalar(cells + i, count - i, matID) << i : 0);
 }
+#endif
+
+static u64 matchMaterial(const Cell *cells, u32 count, u8 matID) {
+#if defined(PIXEL_X86) && defined(PIXEL_COMPACT_CELLS)
+    static const auto kernel = matIDInLowBits() ? matchMaterial_SSE2 : matchMaterial_Scalar;
+    return kernel(cells, count, matID);
+#elif defined(PIXEL_X86)
+    static const auto kernel = cpuFeatures().avx2 ? matchMaterial_AVX2 : matchMaterial_SSE2;
+    return kernel(cells, count, matID);
+#else
+    return matchMaterial_Scalar(cells, count, matID);
+#endif
+}
+
+// Scanline flood fill from (x, y), fills every 4-connected cell of the seed's material.
+// Works 64 cells at a time: a row is turned into a word of 'fillable' bits, runs & neighbouring seeds
+// are then found with bit tricks instead of per cell checks. Each run is painted in one paintRun() call.
+// strokeCoverage doubles as the visited set, so holding the mouse on a filled region doesn't refill it
+// and drawChance < 100 leaves holes instead of letting the fill leak back in.
+void Game::floodFill(u16 x, u16 y, u8 material) {
+    const u8 target = cells[cellIdx(x, y)].matID;
+    if (target == material || strokeCoverage.test(x, y)) return;
+
+    const u16 words = (cellWidth + 63) / 64;
+
+    // bit i set if cell (word * 64 + i, y) is the target material and hasn't been filled yet.
+    auto fillable = [&](u16 word, u16 y) -> u64 {
+        const u16 base = word * 64;
+        const u32 count = std::min(64, cellWidth - base);
+        return matchMaterial(&cells[cellIdx(base, y)], count, target) & ~strokeCoverage.word(base, y);
+    };
 
-void Game::drawSquare(u16 x, u16 y, u16 size, u8 material, u8 drawChance, std::function<void(u16, u16, u8)> foo) {
-    for (s32 tY = -size / 2; tY < size / 2; tY++)
-        for (s32 tX = -size / 2; tX < size / 2; tX++)
-            if (getRand<s64>(1, 100) <= drawChance) foo(x + tX, y + tY, material);
+    // queues one seed per fillable stretch of row y between x0 & x1 (inclusive).
+    auto seedRow = [&](u16 x0, u16 x1, u16 y) -> void {
+        u64 carry = 0; // was the last cell of the previous word fillable?
+        for (u16 word = x0 >> 6; word <= x1 >> 6; word++) {
+            const u16 base  = word * 64;
+            const u16 lo    = std::max<s32>(x0 - base, 0);
+            const u16 hi    = std::min<s32>(x1 - base, 63);
+            const u64 range = (hi == 63 ? ~u64(0) : ((u64(1) << (hi + 1)) - 1)) & ~((u64(1) << lo) - 1);
+            const u64 f     = fillable(word, y) & range;
+            for (u64 starts = f & ~((f << 1) | carry); starts; starts &= starts - 1) fillStack.emplace_back(base + std::countr_zero(starts), y);
+            carry = f >> 63;
+        }
+    };
+
+    u64 gap = chanceSampler.nextGap([&]() -> u64 { return splitMix64_NextRand(); });
+    fillStack.clear();
+    fillStack.emplace_back(x, y);
+    while (!fillStack.empty()) {
+        const auto [sx, sy] = fillStack.back();
+        fillStack.pop_back();
+
+        const u16 bit = sx & 63;
+        u64       f   = fillable(sx >> 6, sy);
+        if (!(f >> bit & 1)) continue; // filled by an earlier run since it was queued.
+
+        // extend left, until there's a cell we can't fill.
+        u16 word    = sx >> 6;
+        u64 blocked = ~f & ((u64(1) << bit) - 1);
+        while (!blocked && word > 0) blocked = ~fillable(--word, sy);
+        const u16 x0 = blocked ? (word * 64) + (64 - std::countl_zero(blocked)) : 0;
+
+        // extend right, cells past cellWidth are never fillable so this stops at the edge on its own.
+        word    = sx >> 6;
+        blocked = ~f & ~((u64(2) << bit) - 1);
+        while (!blocked && word + 1 < words) blocked = ~fillable(++word, sy);
+        const u16 x1 = blocked ? (word * 64) + std::countr_zero(blocked) - 1 : cellWidth - 1;
+
+        paintRun(x0, sy, x1 - x0 + 1, material, gap);
+        if (sy > 0) seedRow(x0, x1, sy - 1);
+        if (sy + 1 < cellHeight) seedRow(x0, x1, sy + 1);
+    }
 }
 
-void Game::drawSquareOutline(u16 x, u16 y, u16 size, u8 material, u8 drawChance, std::function<void(u16, u16, u8)> foo) {
-    // draws from centre, not top left.
-    for (s32 tX = -size / 2; tX <= size / 2; tX++)
-        if (getRand<s64>(1, 100) <= drawChance) foo(x + tX, y - size / 2, material);
-    for (s32 tX = -size / 2; tX <= size / 2; tX++)
-        if (getRand<s64>(1, 100) <= drawChance) foo(x + tX, y + size / 2, material);
-    for (s32 tY = -size / 2; tY <= size / 2; tY++)
-        if (getRand<s64>(1, 100) <= drawChance) foo(x - size / 2, y + tY, material);
-    for (s32 tY = -size / 2; tY <= size / 2; tY++)
-        if (getRand<s64>(1, 100) <= drawChance) foo(x + size / 2, y + tY, material);
+// Mouse released, the next press starts a new stroke with an empty coverage mask.
+void Game::endStroke() {
+    if (!strokeActive && strokeCoverage.cellCount() == 0) return;
+    strokeCoverage.clear();
+    strokeActive = false;
 }
 
 /*--------------------------------------------------------------------------------------
 ---- Updating Texture ------------------------------------------------------------------
 --------------------------------------------------------------------------------------*/
 
-// Iterates over textureChanges list, updates relevant textureData with cell
-// data.
+// Walks the textureChanges bitmap in memory order, each dirty cell is written exactly once,
+// contiguous dirty cells are handed to blitCellRow() as a single run. Only the part of a run inside the
+// view is looked up & drawn, the rest just has its updated flags cleared.
 void Game::updateTextureData(std::vector<u8> &textureData) {
-    for (const auto &[x, y] : textureChanges) {
-        Cell                  &c       = cells[cellIdx(x, y)];                   // grab cell with changes
-        const std::vector<u8> &variant = materials[c.matID].variants[c.variant]; // grab cell's colour variant
-
-        const u8 red   = variant[0]; // might be slowing code down?
-        const u8 green = variant[1]; // might be slowing code down?
-        const u8 blue  = variant[2]; // might be slowing code down?
-        const u8 alpha = variant[3]; // might be slowing code down?
-
-        for (s32 tY = 0; tY < scaleFactor; tY++)
-            for (s32 tX = 0; tX < scaleFactor; tX++) { // iterates over each pixel in the cell
-                const s32 texIdx        = textureIdx((x * scaleFactor) + tX,
-                                              (y * scaleFactor) + tY); // index into 1d array
-                textureData[texIdx + 0] = red;
-                textureData[texIdx + 1] = green;
-                textureData[texIdx + 2] = blue;
-                textureData[texIdx + 3] = alpha;
-            }
-        c.updated = false;
-    }
-    textureChanges.clear();
-    textureChanges = drawIndicators;            // clears this frames draw indicators next frame.
-    for (const auto &[x, y] : drawIndicators) { //
-        for (s32 tY = 0; tY < scaleFactor / 2; tY++)
-            for (s32 tX = 0; tX < scaleFactor / 2; tX++) {
-                const s32 texIdx        = textureIdx((x * scaleFactor) + tX, (y * scaleFactor) + tY);
-                textureData[texIdx + 0] = 255;
-                textureData[texIdx + 1] = 255;
-                textureData[texIdx + 2] = 255;
-                textureData[texIdx + 3] = 255;
-            }
-    }
-    drawIndicators.clear();
+    const u32 pitch      = textureWidth * 4;
+    const u16 cols       = viewCols(), rows = viewRows();
+    u32      *rowColours = frameArena.allocate<u32>(cellWidth); // scratch row for blitCellRow()
+
+    u16 top = UINT16_MAX, bottom = 0; // view rows written, uploaded as one band
+    textureChanges.forEachRun([&](u16 x, u16 y, u16 length) -> void {
+        Cell *row = &cells[cellIdx(x, y)];
+        autosave.markRun(x, y, length);
+
+        const s32  from   = std::clamp<s32>(viewX, x, x + length), to = std::clamp<s32>(viewX + cols, from, x + length);
+        const bool inView = y >= viewY && y < viewY + rows && from < to;
+        if (inView)
+            for (s32 i = from; i < to; i++) rowColours[i - from] = palette[paletteIdx(row[i - x])];
+        for (u16 i = 0; i < length; i++) row[i].updated = false;
+        if (!inView) return;
+        blitCellRow(rowColours, to - from, zoom, &textureData[textureIdx((from - viewX) * zoom, (y - viewY) * zoom)], pitch);
+        top    = std::min<u16>(top, y - viewY);
+        bottom = std::max<u16>(bottom, y - viewY);
+    });
+    if (top <= bottom) textureUploads.push_back({0, static_cast<u16>(top * zoom), textureWidth, static_cast<u16>((bottom - top + 1) * zoom)});
 }
 
+// Everything's redrawn. The cells off camera aren't drawn, but their updated flags still have to go.
 void Game::updateEntireTextureData(std::vector<u8> &textureData) {
+    drawView(textureData);
+
+    const s32 cols = viewCols(), rows = viewRows();
     for (s32 y = 0; y < cellHeight; y++) {
-        for (s32 x = 0; x < cellWidth; x++) {
-            Cell                  &c       = cells[cellIdx(x, y)];
-            const std::vector<u8> &variant = materials[c.matID].variants[c.variant];
-
-            const u8 red   = variant[0];
-            const u8 green = variant[1];
-            const u8 blue  = variant[2];
-            const u8 alpha = variant[3];
-
-            for (s32 tY = 0; tY < scaleFactor; tY++)
-                for (s32 tX = 0; tX < scaleFactor; tX++) {
-                    const s32 idx        = textureIdx((x * scaleFactor) + tX, (y * scaleFactor) + tY);
-                    textureData[idx + 0] = red;
-                    textureData[idx + 1] = green;
-                    textureData[idx + 2] = blue;
-                    textureData[idx + 3] = alpha;
-                }
-            c.updated = false;
+        Cell *row      = &cells[cellIdx(0, y)];
+        auto  clearRun = [&](s32 from, s32 to) -> void {
+            for (s32 x = from; x < to; x++)
+                if (row[x].updated) row[x].updated = false;
+        };
+        if (y < viewY || y >= viewY + rows) clearRun(0, cellWidth);
+        else {
+            clearRun(0, viewX);
+            clearRun(viewX + cols, cellWidth);
+        }
+    }
+    textureChanges.clear(); // everything's just been written.
+    autosave.markAll();
+}
+
+// Draws every cell in the view, a whole row of it at a time, so the kernels get long runs to chew through.
+// Chunks of a single coloured material are filled without reading their cells. They're inert too, so a
+// stale updated flag left in one doesn't matter, updateCell() never looks past it.
+void Game::drawView(std::vector<u8> &textureData) {
+    const u32 pitch      = textureWidth * 4;
+    const s32 cols       = viewCols(), rows = viewRows();
+    u32      *rowColours = frameArena.allocate<u32>(cellWidth); // scratch row for blitCellRow(), starts at viewX
+
+    for (s32 y = viewY; y < viewY + rows; y++) {
+        Cell *row = &cells[cellIdx(0, y)];
+        for (s32 cx = viewX / ChunkMap::CHUNK_SIZE; cx * ChunkMap::CHUNK_SIZE < viewX + cols; cx++) {
+            const u8  material = chunks.material(cx, y / ChunkMap::CHUNK_SIZE);
+            const s32 x0       = std::max<s32>(cx * ChunkMap::CHUNK_SIZE, viewX);
+            const s32 x1       = std::min<s32>((cx + 1) * ChunkMap::CHUNK_SIZE, viewX + cols);
+            if (material != ChunkMap::MIXED && flatMaterials[material]) {
+                std::fill(rowColours + (x0 - viewX), rowColours + (x1 - viewX), palette[material * nVariants]);
+                continue;
+            }
+            for (s32 x = x0; x < x1; x++) {
+                rowColours[x - viewX] = palette[paletteIdx(row[x])];
+                if (row[x].updated) row[x].updated = false; // only write if needed, a freshly mapped snapshot stays shared with the file.
+            }
         }
+        blitCellRow(rowColours, cols, zoom, &textureData[textureIdx(0, (y - viewY) * zoom)], pitch);
     }
+    clearTextureBorder(textureData);
+    textureUploads.push_back({0, 0, textureWidth, textureHeight});
 }
 
-void Game::loadImage(std::vector<u8> &textureData, std::vector<u8> &imageTextureData, u16 imageWidth, u16 imageHeight) {}
-/*
-    // ?? scale imageWidth and imageHeight to cellWidth and cellHeight
-    //		^^ only really necessary for low res // really high res
-    // .. interpolate image RGBA --> closest material RGBA
-    // .. .. avoids 100k variant vector stuff.
+// The texels past the last whole cell in the view stay white, like a fresh texture.
+// The texture buffer is resized, not cleared, so they'd show whatever was there before.
+void Game::clearTextureBorder(std::vector<u8> &textureData) {
+    const u32 pitch  = textureWidth * 4;
+    const u32 cellsX = viewCols() * zoom, cellsY = viewRows() * zoom;
+    if (cellsX < textureWidth)
+        for (u32 y = 0; y < cellsY; y++) std::fill(textureData.begin() + (y * pitch) + (cellsX * 4), textureData.begin() + ((y + 1) * pitch), 255);
+    std::fill(textureData.begin() + (cellsY * pitch), textureData.begin() + (textureHeight * pitch), 255);
+}
 
-    // Bounds Checking
-    if (imageWidth > textureWidth || imageWidth <= 0) {
-        printf("Image Width: %d is not within bounds.", imageWidth);
-    } else if (imageHeight > textureHeight || imageHeight <= 0) {
-        printf("Image Height: %d is not within bounds.", imageHeight);
+// The grid only grew since the texture was last written & the camera stayed put: the old texels move to the new
+// row pitch (last row first, the rows only ever move towards the end), then just the cells the view gained are drawn.
+// The GL texture keeps the old texels where they were, so only the strips on the right & bottom need uploading.
+void Game::updateGrownTextureData(std::vector<u8> &textureData) {
+    const u32 pitch    = textureWidth * 4;
+    const u32 oldPitch = grownFrom.textureWidth * 4;
+    if (pitch != oldPitch)
+        for (u32 y = grownFrom.textureHeight; y-- > 0;) std::memmove(&textureData[y * pitch], &textureData[y * oldPitch], oldPitch);
+
+    clearTextureBorder(textureData);
+    const u16 cols       = viewCols(), rows = viewRows();
+    u32      *rowColours = frameArena.allocate<u32>(cellWidth);
+    for (u32 y = 0; y < rows; y++) {
+        const u32 x = y < grownFrom.viewRows ? grownFrom.viewCols : 0;
+        if (x >= cols) continue;
+        Cell *row = &cells[cellIdx(viewX + x, viewY + y)];
+        for (u32 i = 0; i < cols - x; i++) rowColours[i] = palette[paletteIdx(row[i])];
+        blitCellRow(rowColours, cols - x, zoom, &textureData[textureIdx(x * zoom, y * zoom)], pitch);
     }
 
-    u16 scaledWidth  = imageWidth / (scaleFactor);  // texture --> cell scale
-    u16 scaledHeight = imageHeight / (scaleFactor); // texture --> cell scale
+    const u16 oldX = grownFrom.viewCols * zoom, oldY = grownFrom.viewRows * zoom;
+    if (textureWidth != grownFrom.textureWidth) textureUploads.push_back({oldX, 0, static_cast<u16>(textureWidth - oldX), oldY});
+    if (textureHeight != grownFrom.textureHeight) textureUploads.push_back({0, oldY, textureWidth, static_cast<u16>(textureHeight - oldY)});
+    grown = false;
+}
 
-    for (u16 y = 0; y < scaledHeight; y++) {
-        for (u16 x = 0; x < scaledWidth; x++) {
+// Flattens each material's variants into one packed RGBA table, indexed by paletteIdx().
+void Game::buildPalette() {
+    colourLUT.clear(); // stale now, rebuilt by the next loadImage().
+    palette.assign(materials.size() * nVariants, 0);
+    for (u32 matID = 0; matID < materials.size(); matID++)
+        for (u32 i = 0; i < nVariants; i++) {
+            const std::vector<u8> &variant     = materials[matID].variants[i];
+            palette[(matID * nVariants) + i] = packRGBA(variant[0], variant[1], variant[2], variant[3]);
+        }
+
+    // inert & every variant the same colour, see updateEntireTextureData()
+    for (u32 matID = 0; matID < materials.size(); matID++)
+        flatMaterials[matID] = inert(matID) && std::all_of(&palette[matID * nVariants], &palette[(matID + 1) * nVariants], [&](u32 colour) -> bool { return colour == palette[matID * nVariants]; });
+}
+
+/*--------------------------------------------------------------------------------------
+---- Image Import ----------------------------------------------------------------------
+--------------------------------------------------------------------------------------*/
 
-            // for each material, s32 diff = (img.r - mat.r) + (img.g - mat.g)
-... s16 curDiff = INT16_MAX;
-            //u8  matID = 0, variantID = 0;
-            std::vector<u8> &closest = materials[MaterialID::SAND].variants[0];
-            for (u8 i = 0; i < materials.size(); i++) {
-                for (u8 j = 0; j < materials[i].variants.size(); j++) {
-                    std::vector<u8> &mat  = materials[i].variants[j];
-                    s16              diff = ();
-                    if (diff < curDiff) {
-                        mat =
+// 5 bits per channel, 32 x 32 x 32 buckets. A bucket stands in for the colour at its centre.
+static constexpr u32 LUT_BITS = 5;
+static u32           lutIdx(u32 r, u32 g, u32 b) { return ((r >> 3) << (2 * LUT_BITS)) | ((g >> 3) << LUT_BITS) | (b >> 3); }
+
+// For each RGB bucket, the cell of the palette entry nearest its centre.
+// 32K buckets against the whole palette costs a few ms once per palette, instead of once per pixel on every import.
+// Only distinct colours are searched, most materials have every variant the same. The first of equals is kept, so
+// ties still go to the lowest palette index. The red & green part of the distance is shared by a whole column of blues.
+void Game::buildColourLUT() {
+    MemoryScope      tag(MemoryTag::PALETTE);
+    std::vector<u32> distinct;                   // palette indices
+    std::vector<s32> r, g, b, redGreen;
+    for (u32 i = 0; i < palette.size(); i++) {
+        if (std::any_of(distinct.begin(), distinct.end(), [&](u32 j) -> bool { return (palette[j] & 0xFFFFFF) == (palette[i] & 0xFFFFFF); })) continue;
+        distinct.push_back(i);
+        r.push_back(palette[i] & 0xFF);
+        g.push_back((palette[i] >> 8) & 0xFF);
+        b.push_back((palette[i] >> 16) & 0xFF);
+    }
+    redGreen.resize(distinct.size());
+
+    colourLUT.resize(1 << (3 * LUT_BITS));
+    constexpr u32 BUCKETS = 1 << LUT_BITS;
+    for (u32 bR = 0; bR < BUCKETS; bR++)
+        for (u32 bG = 0; bG < BUCKETS; bG++) {
+            const s32 cR = (bR << 3) + 4, cG = (bG << 3) + 4;
+            for (u32 i = 0; i < distinct.size(); i++) redGreen[i] = ((cR - r[i]) * (cR - r[i])) + ((cG - g[i]) * (cG - g[i]));
+            for (u32 bB = 0; bB < BUCKETS; bB++) {
+                const s32 cB           = (bB << 3) + 4;
+                s32       bestDistance = INT32_MAX;
+                u32       best         = 0;
+                for (u32 i = 0; i < distinct.size(); i++) {
+                    const s32 distance = redGreen[i] + ((cB - b[i]) * (cB - b[i]));
+                    if (distance < bestDistance) {
+                        bestDistance = distance;
+                        best         = distinct[i];
                     }
                 }
+                colourLUT[(bR << (2 * LUT_BITS)) | (bG << LUT_BITS) | bB] = Cell(false, best / nVariants, best % nVariants, 0);
             }
-
-            const u8 red   = closest[0];
-            const u8 green = closest[1];
-            const u8 blue  = closest[2];
-            const u8 alpha = closest[3];
-
-            // update renderTexture
-            for (u8 tY = 0; tY < scaleFactor; tY++)
-                for (u8 tX = 0; tX < scaleFactor; tX++) {
-                    const u32 idx        = textureIdx((x * scaleFactor) + tX, (y
-* scaleFactor) + tY); textureData[idx + 0] = red; textureData[idx + 1] = green;
-                    textureData[idx + 2] = blue;
-                    textureData[idx + 3] = alpha;
-                }
-        }
-}*/
-
-// Instead of Variant schenanigans, do the 'next' step for image loading,
-// find the material it is closest to, and set it to that!
-// So I should probably add more materials.
-/*
-void Game::loadImage(std::vector<GLubyte>& imageTextureData, u16 imageWidth, u16
-imageHeight)
-{
-    Material sand = materials[MaterialID::SAND]; // used as baseline.
-
-    u16 scaledWidth = imageWidth / (scaleFactor * scaleFactor);
-    u16 scaledHeight = imageHeight / (scaleFactor * scaleFactor);
-    if (scaledWidth > cellWidth) {
-        printf("Image Width too large! by: %d", scaledWidth - cellWidth);
-        scaledWidth = cellWidth;
-    }
-    if (scaledHeight > cellHeight) {
-        printf("Image Height too large! by: %d", scaledHeight - cellHeight);
-        scaledHeight = cellHeight;
-    }
-
-    materials.push_back(Material(sand.r, sand.g, sand.b, sand.a, sand.density));
-// create new material for image const u16 imgMatIdx = materials.size() - 1; //
-if there are more than 65536 materials, it deserves to die. Material& imgMat =
-materials[imgMatIdx];
-
-    u32 texIdx = 0;
-    u32 cellIdx = 0;
-    for (s32 y = 0; y < scaledHeight; y++)
-        for (s32 x = 0; x < scaledWidth; x++) {
-            imgMat.variants.push_back({
-                    imageTextureData[texIdx + 0],
-                    imageTextureData[texIdx + 1],
-                    imageTextureData[texIdx + 2],
-                    imageTextureData[texIdx + 3]});
-            cells[cellIdx].matID = imgMatIdx;
-            cells[cellIdx].variant = imgMat.variants.size() - 1;
-
-            texIdx += 4;
-            cellIdx++;
         }
 }
-*/
-
-/*
-// slightly more challenging, can't set exact RGBA values, unless I create a new
-variant ?
-// create a new Material 'Image{ID}' ?
-// Can't add a new index into MaterialID enum, not alterable at Runtime.
-// Create a vector for Img Variants.
-void Game::loadImage(std::vector<GLubyte> imageTextureData, u16 imageWidth, u16
-imageHeight)
-{
-    Material sand = materials[MaterialID::SAND]; // used as baseline.
-
-    u16 scaledWidth  = imageWidth  / (scaleFactor * scaleFactor);
-    u16 scaledHeight = imageHeight / (scaleFactor * scaleFactor);
-    if (scaledWidth  > cellWidth)  scaledWidth  = cellWidth;
-    if (scaledHeight > cellHeight) scaledHeight = cellHeight;
-
-    std::unordered_map<int, int> variantMap; // lets hope it initialises ints
-when idx created.. auto hashRGBA = [](u8 r, u8 g, u8 b, u8 a) -> u32 { return r
-* g * b * a % r+g+b+a; // simplest hash ever, slow though..
-    };
 
-    materials.push_back(Material(sand.r, sand.g, sand.b, sand.a, sand.density));
-// create new material for image Material& imgMat = materials[materials.size() -
-1];
-
-    // puts the picture in top left of screen
-    u32 idx = 0;
-    for (s32 y = 0; y < scaledHeight; y++)
-        for (s32 x = 0; x < scaledWidth; x++) {
-            // for each new RGBA, if (copy)
-            //	if copy -> use pre-existing variant idx
-            //	else -> create new variant, use that
-            //
-            // copy == hashRGBA(r,g,b,a)
-            //
-            // R*G*B*A --> hash map --> profit?
-
-            Cell& c = cells[cellIdx(x, y)];
-            c.matID = materials.size() - 1; // set material to imgMat.
-
-            // doesn't have any leeway for colours that are practically
-identical.
-            // going to make more variants than neccessary.. oh well.
-            if (variantMap[hashRGBA()] == 0) { // create new variant
-                imgMat.variants.push_back({
-                    imageTextureData[idx + 0],
-                    imageTextureData[idx + 1],
-                    imageTextureData[idx + 2],
-                    imageTextureData[idx + 3]}); // initialising all these
-vectors is going to kill me.. c.variant = imgMat.variants.size() - 1;
-                variantMap[idx] = 100;
-            } else // use pre-existing variant , perfection
-                c.variant = variantMap[idx];
-
-            idx += 4;
+// One row of a 1:1 import, each RGBA pixel straight through the LUT into a cell.
+static void lookupRow_Scalar(Cell *row, const u8 *src, u32 count, const Cell *lut) {
+    for (u32 x = 0; x < count; x++, src += 4) row[x] = lut[lutIdx(src[0], src[1], src[2])];
+}
+
+#if defined(PIXEL_X86)
+static_assert(LUT_BITS == 5, "the SIMD lutIdx() below assumes 5 bits per channel");
+
+// lutIdx() of 4 little endian RGBA pixels: red bits 3-7 to 10-14, green 11-15 to 5-9, blue 19-23 to 0-4.
+static __m128i lutIdx_SSE2(__m128i px) {
+    const __m128i red   = _mm_and_si128(_mm_slli_epi32(px, 7), _mm_set1_epi32(0x7C00));
+    const __m128i green = _mm_and_si128(_mm_srli_epi32(px, 6), _mm_set1_epi32(0x3E0));
+    const __m128i blue  = _mm_and_si128(_mm_srli_epi32(px, 19), _mm_set1_epi32(0x1F));
+    return _mm_or_si128(_mm_or_si128(red, green), blue);
+}
+
+static void lookupRow_SSE2(Cell *row, const u8 *src, u32 count, const Cell *lut) {
+    alignas(16) u32 idx[4];
+    u32             x = 0;
+    for (; x + 4 <= count; x += 4) { // the indices 4 at a time, the lookups stay scalar
+        _mm_store_si128(reinterpret_cast<__m128i *>(idx), lutIdx_SSE2(_mm_loadu_si128(reinterpret_cast<const __m128i *>(src + (x * 4)))));
+        row[x + 0] = lut[idx[0]];
+        row[x + 1] = lut[idx[1]];
+        row[x + 2] = lut[idx[2]];
+        row[x + 3] = lut[idx[3]];
+    }
+    lookupRow_Scalar(row + x, src + (x * 4), count - x, lut);
+}
+
+#if !defined(PIXEL_COMPACT_CELLS)
+TARGET_AVX2 static void lookupRow_AVX2(Cell *row, const u8 *src, u32 count, const Cell *lut) {
+    u32 x = 0;
+    for (; x + 8 <= count; x += 8) { // 8 pixels per gather, a 4 byte cell is one i32 lane
+        const __m256i px    = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + (x * 4)));
+        const __m256i red   = _mm256_and_si256(_mm256_slli_epi32(px, 7), _mm256_set1_epi32(0x7C00));
+        const __m256i green = _mm256_and_si256(_mm256_srli_epi32(px, 6), _mm256_set1_epi32(0x3E0));
+        const __m256i blue  = _mm256_and_si256(_mm256_srli_epi32(px, 19), _mm256_set1_epi32(0x1F));
+        const __m256i idx   = _mm256_or_si256(_mm256_or_si256(red, green), blue);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(row + x), _mm256_i32gather_epi32(reinterpret_cast<const int *>(lut), idx, 4));
+    }
+    lookupRow_Scalar(row + x, src + (x * 4), count - x, lut);
+}
+#endif
+#endif
+
+static void lookupRow(Cell *row, const u8 *src, u32 count, const Cell *lut) {
+#if defined(PIXEL_X86) && defined(PIXEL_COMPACT_CELLS)
+    lookupRow_SSE2(row, src, count, lut);
+#elif defined(PIXEL_X86)
+    static const auto kernel = cpuFeatures().avx2 ? lookupRow_AVX2 : lookupRow_SSE2;
+    kernel(row, src, count, lut);
+#else
+    lookupRow_Scalar(row, src, count, lut);
+#endif
+}
+
+// sum[i] += src[i], a band row of the import's box filter. At -O2 gcc leaves the widening adds scalar.
+static void addRow_Scalar(u32 *__restrict sum, const u8 *src, u32 count) {
+    for (u32 i = 0; i < count; i++) sum[i] += src[i];
+}
+
+#if defined(PIXEL_X86)
+static void addRow_SSE2(u32 *__restrict sum, const u8 *src, u32 count) {
+    const __m128i zero = _mm_setzero_si128();
+    u32           i    = 0;
+    for (; i + 16 <= count; i += 16) { // 16 bytes widened to 4 x 4 u32s
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        const __m128i lo    = _mm_unpacklo_epi8(bytes, zero);
+        const __m128i hi    = _mm_unpackhi_epi8(bytes, zero);
+        __m128i      *out   = reinterpret_cast<__m128i *>(sum + i);
+        _mm_storeu_si128(out + 0, _mm_add_epi32(_mm_loadu_si128(out + 0), _mm_unpacklo_epi16(lo, zero)));
+        _mm_storeu_si128(out + 1, _mm_add_epi32(_mm_loadu_si128(out + 1), _mm_unpackhi_epi16(lo, zero)));
+        _mm_storeu_si128(out + 2, _mm_add_epi32(_mm_loadu_si128(out + 2), _mm_unpacklo_epi16(hi, zero)));
+        _mm_storeu_si128(out + 3, _mm_add_epi32(_mm_loadu_si128(out + 3), _mm_unpackhi_epi16(hi, zero)));
+    }
+    addRow_Scalar(sum + i, src + i, count - i);
+}
+#endif
+
+static void addRow(u32 *__restrict sum, const u8 *src, u32 count) {
+#if defined(PIXEL_X86)
+    addRow_SSE2(sum, src, count);
+#else
+    addRow_Scalar(sum, src, count);
+#endif
+}
+
+// Turns an RGBA image into cells: scaled to fit the grid (aspect kept, centred), each cell gets the material & variant
+// closest to its average colour. Downscaling is a box filter done in one pass over the image, each row of cells sums its
+// band of image rows per column, folds the columns into cells, then quantises through colourLUT straight into cells.
+// Anything outside the image is left alone.
+void Game::loadImage(const std::vector<u8> &image, u16 imageWidth, u16 imageHeight) {
+    if (imageWidth == 0 || imageHeight == 0 || image.size() < static_cast<size_t>(imageWidth) * imageHeight * 4) return;
+    if (colourLUT.empty()) buildColourLUT();
+
+    u32 width = cellWidth, height = cellHeight;
+    if (static_cast<u64>(imageWidth) * cellHeight > static_cast<u64>(imageHeight) * cellWidth) height = std::max<u64>(1, static_cast<u64>(cellWidth) * imageHeight / imageWidth);
+    else width = std::max<u64>(1, static_cast<u64>(cellHeight) * imageWidth / imageHeight);
+    const u32 offsetX = (cellWidth - width) / 2;
+    const u32 offsetY = (cellHeight - height) / 2;
+
+    // image columns [columnStart[x], columnEnd[x]) land in cell column x, at least one each when scaling up.
+    std::vector<u32> columnStart(width), columnEnd(width);
+    for (u32 x = 0; x < width; x++) {
+        columnStart[x] = static_cast<u64>(x) * imageWidth / width;
+        columnEnd[x]   = std::max<u32>(columnStart[x] + 1, static_cast<u64>(x + 1) * imageWidth / width);
+    }
+    const bool oneToOne = width == imageWidth && height == imageHeight; // no averaging, straight through the LUT.
+
+    std::vector<u32> sums(static_cast<size_t>(imageWidth) * 4); // RGBA sums of the current band, per image column
+    std::vector<u32> inverse(width);                            // 2^24 / pixels averaged into each cell of the row, saves 3 divides a cell
+    u32              bandRows = 0;
+
+    // a Cell is made of u8s, so a store to one may alias anything as far as the compiler knows, vector members included.
+    // Without these locals every cell written reloads colourLUT.data(), image.data() & friends.
+    const Cell *lut    = colourLUT.data();
+    const u8   *pixels = image.data();
+    const u32  *starts = columnStart.data(), *ends = columnEnd.data(), *inv = inverse.data();
+    u32        *sum    = sums.data();
+    for (u32 y = 0; y < height; y++) {
+        Cell *row = &cells[cellIdx(offsetX, offsetY + y)];
+        if (oneToOne) {
+            lookupRow(row, &pixels[static_cast<size_t>(y) * imageWidth * 4], width, lut);
+            continue;
         }
 
-    printf("Initialised Image, Variant size of: %d \n", imgMat.variants.size());
+        const u32 rowStart = static_cast<u64>(y) * imageHeight / height;
+        const u32 rowEnd   = std::max<u32>(rowStart + 1, static_cast<u64>(y + 1) * imageHeight / height);
+        if (rowEnd - rowStart != bandRows) {
+            bandRows = rowEnd - rowStart;
+            for (u32 x = 0; x < width; x++) inverse[x] = (1 << 24) / ((columnEnd[x] - columnStart[x]) * bandRows);
+        }
+        std::fill(sums.begin(), sums.end(), 0);
+        for (u32 iy = rowStart; iy < rowEnd; iy++) addRow(sum, &pixels[static_cast<size_t>(iy) * imageWidth * 4], imageWidth * 4); // alpha comes along for free
+        for (u32 x = 0; x < width; x++) {
+            u32 r = 0, g = 0, b = 0;
+            for (u32 ix = starts[x]; ix < ends[x]; ix++) {
+                r += sum[(ix * 4) + 0];
+                g += sum[(ix * 4) + 1];
+                b += sum[(ix * 4) + 2];
+            }
+            row[x] = lut[lutIdx((static_cast<u64>(r) * inv[x]) >> 24, (static_cast<u64>(g) * inv[x]) >> 24, (static_cast<u64>(b) * inv[x]) >> 24)];
+        }
+    }
+
+    sizeChanged = true; // the whole texture gets rewritten, cheaper than marking most of the cells.
+    rewindStale = true;
+    strokeCoverage.clear();
+    strokeActive = false;
 }
-*/
@@ -0,0 +1,349 @@
+#pragma once
+#include "inputlog.h"
+#include "game.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+
+static constexpr size_t FLUSH_BYTES  = 64 * 1024;
+static constexpr u32    REPORT_TICKS = 500; // frames per line of replay timings
+
+static u32 zigzag(s32 value) { return (static_cast<u32>(value) << 1) ^ static_cast<u32>(value >> 31); }
+static s32 unzigzag(u32 value) { return static_cast<s32>(value >> 1) ^ -static_cast<s32>(value & 1); }
+
+/*--------------------------------------------------------------------------------------
+---- Recording -------------------------------------------------------------------------
+--------------------------------------------------------------------------------------*/
+
+bool InputLog::record(const std::string& path, const AppState& state) {
+    stop();
+    file.open(path, std::ios::binary | std::ios::app);
+    if (!file) {
+        std::cout << "Unable to record inputs to " << path << '\n';
+        return false;
+    }
+    current   = InputLogMode::RECORDING;
+    ticks     = 0;
+    bytes     = 0;
+    idleTicks = 0;
+    stroke    = false;
+    drawX     = 0;
+    drawY     = 0;
+
+    // the log starts with every setting, whoever replays it might not have the same defaults.
+    brush = brushOf(state);
+    sim   = simOf(state);
+    op(InputOp::BRUSH);
+    putVarint(buffer, brush.size);
+    buffer.insert(buffer.end(), {brush.chance, brush.material, brush.shape});
+    op(InputOp::SIM);
+    buffer.insert(buffer.end(), {sim.runSim, sim.scanMode, sim.fluidDispersion, sim.solidDispersion});
+    return true;
+}
+
+void InputLog::stop() {
+    if (current == InputLogMode::RECORDING) {
+        writeTicks();
+        flush();
+        file.close();
+        std::cout << "[Pixel Sim] Recorded " << ticks << " frames of input, " << bytes << " bytes" << std::endl;
+    }
+    log.clear();
+    log.shrink_to_fit();
+    read    = nullptr;
+    current = InputLogMode::OFF;
+}
+
+void InputLog::settings(const AppState& state) {
+    if (current != InputLogMode::RECORDING) return;
+    if (brushOf(state) != brush) {
+        brush = brushOf(state);
+        op(InputOp::BRUSH);
+        putVarint(buffer, brush.size);
+        buffer.insert(buffer.end(), {brush.chance, brush.material, brush.shape});
+    }
+    if (simOf(state) != sim) {
+        sim = simOf(state);
+        op(InputOp::SIM);
+        buffer.insert(buffer.end(), {sim.runSim, sim.scanMode, sim.fluidDispersion, sim.solidDispersion});
+    }
+}
+
+void InputLog::draw(u16 x, u16 y) {
+    if (current != InputLogMode::RECORDING) return;
+    op(InputOp::DRAW);
+    putVarint(buffer, zigzag(x - drawX)); // the mouse doesn't go far in a frame, mostly a byte each.
+    putVarint(buffer, zigzag(y - drawY));
+    drawX  = x;
+    drawY  = y;
+    stroke = true;
+}
+
+void InputLog::endStroke() {
+    if (current != InputLogMode::RECORDING || !stroke) return; // called every frame the mouse is up, only log the release.
+    op(InputOp::END_STROKE);
+    stroke = false;
+}
+
+void InputLog::reset() {
+    if (current == InputLogMode::RECORDING) op(InputOp::RESET);
+}
+
+void InputLog::reload(u16 textureWidth, u16 textureHeight, u8 scaleFactor) {
+    if (current != InputLogMode::RECORDING) return;
+    op(InputOp::RELOAD);
+    putVarint(buffer, textureWidth);
+    putVarint(buffer, textureHeight);
+    buffer.push_back(scaleFactor);
+}
+
+void InputLog::tick(const AppState& state) {
+    if (current != InputLogMode::RECORDING) return;
+    idleTicks++;
+    ticks++;
+    sim = simOf(state); // simulate() flips the scan mode itself, only log what the user changes.
+    if (buffer.size() >= FLUSH_BYTES) flush();
+}
+
+void InputLog::op(u8 code) {
+    writeTicks();
+    buffer.push_back(code);
+}
+
+// frames with no input in between are counted up & written as one TICKS, right before the next op.
+void InputLog::writeTicks() {
+    if (!idleTicks) return;
+    buffer.push_back(InputOp::TICKS);
+    putVarint(buffer, idleTicks);
+    idleTicks = 0;
+}
+
+void InputLog::flush() {
+    file.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+    file.flush(); // so a crash still leaves everything up to the last flush.
+    bytes += buffer.size();
+    buffer.clear();
+}
+
+/*--------------------------------------------------------------------------------------
+---- Replaying -------------------------------------------------------------------------
+--------------------------------------------------------------------------------------*/
+
+// Reads the inputs after the snapshot & checks them all up front, so a bad log never gets half replayed.
+bool InputLog::replay(const std::string& path, SnapshotHeader& header) {
+    stop();
+    std::ifstream   in(path, std::ios::binary);
+    std::vector<u8> contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    const char* error = nullptr;
+    if (!in.is_open()) error = "can't open file";
+    else if (contents.size() < sizeof(header)) error = "not an input log";
+    else {
+        std::memcpy(&header, contents.data(), sizeof(header));
+        if (header.version < 3) header.chunkBytes = 0; // was padding
+        const u64 size = contents.size();
+        if (header.magic != SnapshotHeader::MAGIC || header.headerBytes > size || header.planeBytes > size - header.headerBytes || header.chunkBytes > size - header.headerBytes - header.planeBytes) error = "not an input log";
+    }
+    if (error) {
+        std::cout << "Unable to replay " << path << ": " << error << '\n';
+        return false;
+    }
+
+    log.assign(contents.begin() + header.headerBytes + header.planeBytes + header.chunkBytes, contents.end());
+    current = InputLogMode::REPLAYING;
+    bytes   = log.size();
+    drawX   = 0;
+    drawY   = 0;
+    corrupt = false;
+    ticked  = false;
+    tickRun = 0;
+    read    = log.data();
+
+    AppState   scratch;
+    InputEvent event;
+    totalTicks = 0;
+    while (next(scratch, event)) totalTicks += event.op == InputOp::TICKS;
+    if (corrupt || totalTicks == 0) {
+        std::cout << "Unable to replay " << path << ": " << (corrupt ? "corrupt inputs" : "no inputs recorded") << '\n';
+        stop();
+        return false;
+    }
+
+    drawX   = 0;
+    drawY   = 0;
+    tickRun = 0;
+    ticks   = 0;
+    ticked  = false;
+    read    = log.data();
+    return true;
+}
+
+void InputLog::apply(AppState& state) const {
+    state.drawSize              = brush.size;
+    state.drawChance            = brush.chance;
+    state.drawMaterial          = brush.material;
+    state.drawShape             = brush.shape;
+    state.runSim                = sim.runSim;
+    state.scanMode              = sim.scanMode;
+    state.fluidDispersionFactor = sim.fluidDispersion;
+    state.solidDispersionFactor = sim.solidDispersion;
+}
+
+// The settings are written into 'state' before every event, so fiddling with the UI mid-replay can't change the outcome.
+bool InputLog::next(AppState& state, InputEvent& event) {
+    if (current != InputLogMode::REPLAYING) return false;
+    if (ticked) sim.scanMode = state.scanMode; // simulate() flips it itself, same as tick() picks up when recording.
+    ticked = false;
+    const u8* end  = log.data() + log.size();
+    auto      fail = [&]() -> bool {
+        corrupt = true;
+        return false;
+    };
+    auto emit = [&](u8 code) -> bool {
+        event.op = code;
+        apply(state);
+        return true;
+    };
+
+    while (true) {
+        if (tickRun > 0) {
+            tickRun--;
+            ticks++;
+            ticked = true;
+            return emit(InputOp::TICKS);
+        }
+        if (read >= end) return false;
+
+        u32 a = 0, b = 0;
+        switch (*read++) {
+        case InputOp::TICKS:
+            if (!getVarint(read, end, tickRun) || tickRun == 0) return fail();
+            break;
+        case InputOp::DRAW:
+            if (!getVarint(read, end, a) || !getVarint(read, end, b)) return fail();
+            drawX += unzigzag(a);
+            drawY += unzigzag(b);
+            if (drawX < 0 || drawX > UINT16_MAX || drawY < 0 || drawY > UINT16_MAX) return fail();
+            event.x = drawX;
+            event.y = drawY;
+            return emit(InputOp::DRAW);
+        case InputOp::END_STROKE: return emit(InputOp::END_STROKE);
+        case InputOp::RESET: return emit(InputOp::RESET);
+        case InputOp::BRUSH:
+            if (!getVarint(read, end, a) || a > UINT16_MAX || end - read < 3) return fail();
+            brush = {static_cast<u16>(a), read[0], read[1], read[2]};
+            read += 3;
+            if (brush.chance > 100 || brush.material >= MaterialID::COUNT || brush.shape >= Shape::COUNT) return fail();
+            break;
+        case InputOp::SIM:
+            if (end - read < 4) return fail();
+            sim = {read[0], read[1], read[2], read[3]};
+            read += 4;
+            if (sim.scanMode >= Scan::COUNT) return fail();
+            break;
+        case InputOp::RELOAD:
+            if (!getVarint(read, end, a) || !getVarint(read, end, b) || a > UINT16_MAX || b > UINT16_MAX || read >= end) return fail();
+            event.x           = a;
+            event.y           = b;
+            event.scaleFactor = *read++;
+            if (event.scaleFactor == 0) return fail();
+            return emit(InputOp::RELOAD);
+        default: return fail();
+        }
+    }
+}
+
+/*--------------------------------------------------------------------------------------
+---- Headless Replay -------------------------------------------------------------------
+--------------------------------------------------------------------------------------*/
+
+static f64 msSince(std::chrono::steady_clock::time_point start) { return std::chrono::duration<f64, std::milli>(std::chrono::steady_clock::now() - start).count(); }
+
+struct StageTimes {
+    f64 draw = 0, sim = 0, texture = 0, history = 0, frame = 0, worst = 0;
+    u32 frames = 0;
+};
+
+static void printStages(const char* label, const StageTimes& t) {
+    const f64 n = std::max<u32>(t.frames, 1);
+    printf("%-14s %7u %10.3f %10.3f %10.3f %10.3f %10.3f %10.3f\n", label, t.frames, t.draw / n, t.sim / n, t.texture / n, t.history / n, t.frame / n, t.worst);
+}
+
+// Replays a log as fast as it'll go, the same way Framework::update() applies live input.
+int runReplay(const std::string& path) {
+    InputLog       log;
+    SnapshotHeader header;
+    if (!log.replay(path, header)) return 1;
+
+    AppState state;
+    state.autosaveInterval = 0; // a replay shouldn't be writing files behind your back.
+    state.scaleFactor      = header.scaleFactor;
+    u16             textureWidth  = header.cellWidth * header.scaleFactor;
+    u16             textureHeight = header.cellHeight * header.scaleFactor;
+    std::vector<u8> texture;
+    {
+        MemoryScope tag(MemoryTag::TEXTURES);
+        texture.assign(static_cast<size_t>(textureWidth) * textureHeight * 4, 255);
+    }
+
+    Game game;
+    game.init(textureWidth, textureHeight, state.scaleFactor);
+    if (!game.loadSnapshot(path, state.frame)) return 1;
+
+    printf("replaying %s: %ux%u cells, %u frames, %u bytes of input\n", path.c_str(), header.cellWidth, header.cellHeight, log.length(), log.byteCount());
+    printf("%-14s %7s %10s %10s %10s %10s %10s %10s\n", "frames", "count", "draw (ms)", "sim (ms)", "tex (ms)", "hist (ms)", "frame (ms)", "worst (ms)");
+
+    StageTimes window, total;
+    InputEvent event;
+    f64        drawMs = 0; // painted before the frame's update()
+    const auto start  = std::chrono::steady_clock::now();
+    while (log.next(state, event)) {
+        switch (event.op) {
+        case InputOp::DRAW: {
+            const auto drawStart = std::chrono::steady_clock::now();
+            game.drawAt(event.x / state.scaleFactor, event.y / state.scaleFactor, state.drawSize, state.drawChance, state.drawMaterial, state.drawShape);
+            drawMs += msSince(drawStart);
+        } break;
+        case InputOp::END_STROKE: game.endStroke(); break;
+        case InputOp::RESET: game.reset(); break;
+        case InputOp::RELOAD: {
+            MemoryScope tag(MemoryTag::TEXTURES); // Game tags its own
+            textureWidth      = event.x;
+            textureHeight     = event.y;
+            state.scaleFactor = event.scaleFactor;
+            texture.resize(static_cast<size_t>(textureWidth) * textureHeight * 4, 255); // Game::update() redraws what it has to
+            game.reload(textureWidth, textureHeight, state.scaleFactor);
+        } break;
+        case InputOp::TICKS: {
+            const auto frameStart = std::chrono::steady_clock::now();
+            game.update(state, texture);
+            const f64 frameMs = msSince(frameStart) + drawMs;
+            for (StageTimes* t : {&window, &total}) {
+                t->draw += drawMs;
+                t->sim += state.simMs;
+                t->texture += state.textureMs;
+                t->history += state.historyMs;
+                t->frame += frameMs;
+                t->worst = std::max(t->worst, frameMs);
+                t->frames++;
+            }
+            drawMs = 0;
+            if (log.tickCount() % REPORT_TICKS == 0 || log.tickCount() == log.length()) {
+                char label[32];
+                snprintf(label, sizeof(label), "%u-%u", log.tickCount() - window.frames + 1, log.tickCount());
+                printStages(label, window);
+                window = StageTimes();
+            }
+        } break;
+        }
+    }
+    printStages("total", total);
+
+    u64 hash = 0xCBF29CE484222325; // FNV-1a of the final texture, two replays of the same log should match.
+    for (u8 byte : texture) hash = (hash ^ byte) * 0x100000001B3;
+    printf("replayed %u frames in %.1f ms, ended on frame %u, texture hash %016llx\n", log.tickCount(), msSince(start), state.frame, static_cast<unsigned long long>(hash));
+    printMemoryReport();
+    return 0;
+}
@@ -1,5 +1,9 @@
 #pragma once
 #include "interface.h"
+#include "blit.h"
+#include "cell.h"
+#include "memtrack.h"
+#include "pixelformat.h"
 #include <algorithm>
 
 Interface::Interface() {}
@@ -25,9 +29,12 @@ void Interface::debugMenu(AppState& state) { // pair of empty brackets {} define
     if (ImGui::TreeNode("Simulation Settings")) {
         ImGui::SeparatorText("Simulation Settings");
         ImGui::Checkbox("Run Simulation", &state.runSim);
+        ImGui::Checkbox("Skip Uniform Chunks", &state.skipUniformChunks);
 
         if (ImGui::Button("Reset Sim")) state.resetSim = true;
 
+        // a replay needs the grid it was recorded on, its RELOADs set the scale.
+        ImGui::BeginDisabled(state.inputLogMode == InputLogMode::REPLAYING);
         if (ImGui::Button("Decrease Cell Scale")) {
             state.scaleFactor--;
             state.reloadGame = true;
@@ -37,8 +44,15 @@ void Interface::debugMenu(AppState& state) { // pair of empty brackets {} define
             state.scaleFactor++;
             state.reloadGame = true;
         }
+        ImGui::EndDisabled();
         state.scaleFactor = std::clamp(state.scaleFactor, (u8)1, (u8)10);
 
+        int resizeSettleMs = state.resizeSettleMs;
+        ImGui::Text("Resize Settle (ms)");
+        ImGui::SameLine();
+        ImGui::InputInt("resize_settle_inputint", &resizeSettleMs, 50, 250);
+        state.resizeSettleMs = std::clamp(resizeSettleMs, 0, 2000);
+
         //ImGui::Text("Update Modes: "); ImGui::SameLine();
         //if (ImGui::BeginCombo("update_modes_combo", Update::names[state.updateMode].data())) {
         //    for (u8 n = 0; n < Update::COUNT; n++) {
@@ -95,6 +109,158 @@ void Interface::debugMenu(AppState& state) { // pair of empty brackets {} define
         ImGui::TreePop();
     }
 
+    if (ImGui::TreeNode("Camera")) {
+        ImGui::SeparatorText("Camera");
+
+        const int zoom = state.zoom ? state.zoom : state.scaleFactor;
+        if (ImGui::Button("-")) state.zoom = std::max(1, zoom - 1);
+        ImGui::SameLine();
+        if (ImGui::Button("+")) state.zoom = std::min<int>(AppState::MAX_ZOOM, zoom + 1);
+        ImGui::SameLine();
+        if (ImGui::Button("Reset")) {
+            state.zoom  = 0;
+            state.viewX = 0;
+            state.viewY = 0;
+        }
+        ImGui::Text("View: (%d, %d), Zoom: %d\n", state.viewX, state.viewY, zoom);
+        ImGui::Text("Visible Cells: %u\n", state.visibleCells);
+        ImGui::TextDisabled("Ctrl + Wheel to zoom, Middle Mouse to pan");
+
+        ImGui::TreePop();
+    }
+
+    if (ImGui::TreeNode("Level of Detail")) {
+        ImGui::SeparatorText("Level of Detail");
+        ImGui::Checkbox("Step Off Screen Chunks Less", &state.simLod);
+        if (state.inputLogMode != InputLogMode::OFF) ImGui::TextDisabled("(off while an input log is running)");
+
+        int nearChunks = state.lodNearChunks;
+        ImGui::Text("Near Chunks");
+        ImGui::SameLine();
+        ImGui::InputInt("lod_near_inputint", &nearChunks, 1, 4);
+        state.lodNearChunks = std::clamp(nearChunks, 0, 255);
+
+        int interval = state.lodInterval;
+        ImGui::Text("Near Interval");
+        ImGui::SameLine();
+        ImGui::InputInt("lod_interval_inputint", &interval, 1, 4);
+        state.lodInterval = std::clamp(interval, 1, 32);
+
+        // one colour per tier, the counts double as the legend for the map below.
+        static constexpr std::array<ImU32, SimTier::COUNT> tierColours{IM_COL32(90, 200, 90, 255), IM_COL32(220, 200, 60, 255), IM_COL32(230, 120, 40, 255), IM_COL32(70, 90, 160, 255)};
+        for (u8 tier = 0; tier < SimTier::COUNT; tier++) {
+            if (tier) ImGui::SameLine();
+            ImGui::TextColored(ImGui::ColorConvertU32ToFloat4(tierColours[tier]), "%s: %u", SimTier::names[tier].data(), state.tierChunks[tier]);
+        }
+
+        ImGui::Checkbox("Show Tier Map", &state.showSimTiers);
+        if (state.showSimTiers && state.simTierCols) {
+            const u16    cols     = state.simTierCols;
+            const u16    rows     = state.simTiers.size() / cols;
+            const f32    size     = std::clamp(ImGui::GetContentRegionAvail().x / cols, 2.0f, 12.0f);
+            const ImVec2 origin   = ImGui::GetCursorScreenPos();
+            ImDrawList*  drawList = ImGui::GetWindowDrawList();
+            for (u16 cy = 0; cy < rows; cy++)
+                for (u16 cx = 0; cx < cols; cx++) {
+                    const ImVec2 min = ImVec2(origin.x + cx * size, origin.y + cy * size);
+                    drawList->AddRectFilled(min, ImVec2(min.x + size - 1, min.y + size - 1), tierColours[state.simTiers[(cy * cols) + cx]]);
+                }
+            ImGui::Dummy(ImVec2(cols * size, rows * size));
+        }
+
+        ImGui::TreePop();
+    }
+
+    if (ImGui::TreeNode("World")) {
+        ImGui::SeparatorText("World");
+
+        // one chunk per click, held down they keep coming.
+        ImGui::PushButtonRepeat(true);
+        if (ImGui::ArrowButton("##pan_left", ImGuiDir_Left)) state.panX--;
+        ImGui::SameLine();
+        if (ImGui::ArrowButton("##pan_up", ImGuiDir_Up)) state.panY--;
+        ImGui::SameLine();
+        if (ImGui::ArrowButton("##pan_down", ImGuiDir_Down)) state.panY++;
+        ImGui::SameLine();
+        if (ImGui::ArrowButton("##pan_right", ImGuiDir_Right)) state.panX++;
+        ImGui::PopButtonRepeat();
+        ImGui::SameLine();
+        ImGui::Text("Chunk (%d, %d)%s\n", state.worldX, state.worldY, state.panPending ? " .. loading" : "");
+
+        int chunkBudget = state.chunkBudget;
+        ImGui::Text("Chunk Budget (MB)");
+        ImGui::SameLine();
+        ImGui::InputInt("chunk_budget_inputint", &chunkBudget, 16, 64);
+        state.chunkBudget = std::clamp(chunkBudget, 0, 4096);
+        ImGui::Text("Resident: %d Chunks, %.1f MB\n", state.residentChunks, state.residentChunkBytes / (1024.0f * 1024.0f));
+        ImGui::Text("On Disk: %d Chunks, %d Loading\n", state.storedChunks, state.loadingChunks);
+        ImGui::Text("Uniform: %d Chunks, %.1f MB Saved\n", state.taggedChunks, state.taggedChunkBytes / (1024.0f * 1024.0f));
+        ImGui::Text("Reads / Writes: %d / %d\n", state.chunkReads, state.chunkWrites);
+
+        ImGui::TreePop();
+    }
+
+    if (ImGui::TreeNode("Saving & Loading")) {
+        ImGui::SeparatorText("Saving & Loading");
+
+        static char str[128] = "world.pxsv";
+        ImGui::InputTextWithHint("Save File", "../Resources/Saves/", str, IM_ARRAYSIZE(str));
+
+        if (ImGui::Button("Save")) {
+            state.saveGame = true;
+            state.savePath = "../Resources/Saves/" + std::string(str);
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Load")) {
+            state.loadGame = true;
+            state.savePath = "../Resources/Saves/" + std::string(str);
+        }
+        bool compress = state.saveEncoding == SnapshotEncoding::RLE;
+        ImGui::Checkbox("Compress Saves (RLE)", &compress);
+        state.saveEncoding = compress ? SnapshotEncoding::RLE : SnapshotEncoding::RAW;
+        ImGui::Text("Last Save / Load: %.2f ms\n", state.snapshotMs);
+
+        int autosaveInterval = state.autosaveInterval;
+        ImGui::Text("Autosave Every (s)");
+        ImGui::SameLine();
+        ImGui::InputInt("autosave_interval_inputint", &autosaveInterval, 10, 60);
+        state.autosaveInterval = std::clamp(autosaveInterval, 0, 3600);
+        ImGui::Text("Autosaves: %d\n", state.autosaveCount);
+        ImGui::Text("Last Autosave: %.2f ms write, %.3f ms stall\n", state.autosaveSaveMs, state.autosaveStallMs);
+        ImGui::Text("Last Autosave Copied: %d / %d Chunks\n", state.autosaveChunks, state.autosaveTotal);
+
+        ImGui::TreePop();
+    }
+
+    if (ImGui::TreeNode("Input Recording")) {
+        ImGui::SeparatorText("Input Recording");
+
+        static char str[128] = "session.pxrec";
+        ImGui::InputTextWithHint("Log File", "../Resources/Recordings/", str, IM_ARRAYSIZE(str));
+
+        if (state.inputLogMode == InputLogMode::OFF) {
+            if (ImGui::Button("Record")) {
+                state.startRecording = true;
+                state.inputLogPath   = "../Resources/Recordings/" + std::string(str);
+            }
+            ImGui::SameLine();
+            if (ImGui::Button("Replay")) {
+                state.startReplay  = true;
+                state.inputLogPath = "../Resources/Recordings/" + std::string(str);
+            }
+            ImGui::TextWrapped("For a headless replay at full speed: app --replay <log>");
+        } else {
+            if (ImGui::Button("Stop")) state.stopInputLog = true;
+            ImGui::SameLine();
+            ImGui::Text("%s", InputLogMode::names[state.inputLogMode].data());
+        }
+        if (state.inputLogMode == InputLogMode::REPLAYING) ImGui::Text("Frame %d / %d\n", state.inputLogTicks, state.inputLogLength);
+        else ImGui::Text("Frames Recorded: %d\n", state.inputLogTicks);
+        ImGui::Text("Log Size: %.1f KB\n", state.inputLogBytes / 1024.0f);
+
+        ImGui::TreePop();
+    }
+
     if (ImGui::TreeNode("Frame Stepping")) {
         ImGui::SeparatorText("Frame Stepping");
 
@@ -129,6 +295,30 @@ void Interface::debugMenu(AppState& state) { // pair of empty brackets {} define
             state.runSim    = true;
         }
 
+        ImGui::SeparatorText("Rewind");
+        int rewindBudget = state.rewindBudget;
+        ImGui::Text("History Budget (MB)");
+        ImGui::SameLine();
+        ImGui::InputInt("rewind_budget_inputint", &rewindBudget, 16, 64);
+        state.rewindBudget = std::clamp(rewindBudget, 0, 4096);
+
+        // seeking pauses the sim, otherwise the next frame would carry on from wherever you landed.
+        auto seek = [&](u64 target) -> void {
+            state.rewindTarget = target;
+            state.seekRewind   = true;
+            state.runSim       = false;
+            doFrameStepping    = false;
+        };
+        if (ImGui::ArrowButton("##rewind_back", ImGuiDir_Left) && state.rewindPosition > state.rewindOldest) seek(state.rewindPosition - 1);
+        ImGui::SameLine();
+        if (ImGui::ArrowButton("##rewind_forward", ImGuiDir_Right) && state.rewindPosition < state.rewindNewest) seek(state.rewindPosition + 1);
+        ImGui::SameLine();
+        u64 position = state.rewindPosition;
+        if (ImGui::SliderScalar("##rewind_slider", ImGuiDataType_U64, &position, &state.rewindOldest, &state.rewindNewest)) seek(position);
+
+        ImGui::Text("History: %llu Steps, %.2f MB, %d Keyframes\n", static_cast<unsigned long long>(state.rewindNewest - state.rewindOldest), state.rewindBytes / (1024.0f * 1024.0f), state.rewindKeyframes);
+        ImGui::Text("Last Seek: %.3f ms\n", state.rewindSeekMs);
+
         ImGui::PopButtonRepeat(); // Imgui configuration is implemented with a stack? interesting
         ImGui::TreePop();
     }
@@ -175,7 +365,7 @@ void Interface::debugMenu(AppState& state) { // pair of empty brackets {} define
         ImGui::SameLine();
         ImGui::InputInt("draw_size_inputint", &drawSize, 1, 10);
         u8 drawSizeModifier = ImGui::IsKeyPressed(ImGui::GetKeyIndex(ImGuiKey_LeftShift)) ? 10 : 1;
-        state.drawSize += (int)io.MouseWheel * drawSizeModifier;
+        if (!io.KeyCtrl) state.drawSize += (int)io.MouseWheel * drawSizeModifier; // ctrl + wheel zooms the camera, see gameWindow()
         state.drawSize = (state.drawSize > 10000) ? 1 : state.drawSize;
         //state.drawSize  = std::clamp(state.drawSize, (u16)1, (u16)10000);
 
@@ -209,16 +399,35 @@ void Interface::debugMenu(AppState& state) { // pair of empty brackets {} define
 
         ImGui::Text("Application Average %.3f ms/frame (%.1f FPS)", 1000.0f / io.Framerate, io.Framerate);
         ImGui::Text("Application Framecount: %d\n", ImGui::GetFrameCount());
+        f32 startupMs = 0;
+        for (u8 i = 0; i < Message::FRAMEWORK_DEAD; i++) startupMs += state.startupMs[i];
+        ImGui::Text("Startup: %.1f ms (hover for stages)\n", startupMs);
+        if (ImGui::IsItemHovered()) {
+            ImGui::BeginTooltip();
+            for (u8 i = 0; i < Message::FRAMEWORK_DEAD; i++) ImGui::Text("%s %.2f ms", Message::names[i].data(), state.startupMs[i]);
+            ImGui::EndTooltip();
+        }
         ImGui::Text("Game Framecount: %d\n", state.frame);
+        ImGui::Text("Draw / Sim / Texture / History: %.2f / %.2f / %.2f / %.2f ms\n", state.drawMs, state.simMs, state.textureMs, state.historyMs);
         ImGui::Text("Scale Factor: %d\n", state.scaleFactor);
         ImGui::Text("Textures Reloaded: %d Times\n", state.texReloadCount);
+        ImGui::Text("Texture Reallocations: %d\n", state.texReallocCount);
         ImGui::Text("Displayed Texture: %s\n", TexID::names[loadedTex].data());
+        ImGui::Text("Blit Kernels: %s\n", blitKernelName().data());
+        ImGui::Text("Pixel Format Kernels: %s\n", pixelFormatKernelName().data());
+        ImGui::Text("Cell Layout: %s (%d Bytes)\n", sizeof(Cell) == 2 ? "Compact" : "Default", static_cast<int>(sizeof(Cell)));
         ImGui::Text("Texture Width: %d\n", texture.width);
         ImGui::Text("Texture Height: %d\n", texture.height);
         ImGui::Text("Cell Width: %d\n", texture.width / state.scaleFactor);
         ImGui::Text("Cell Height: %d\n", texture.height / state.scaleFactor);
-        ImGui::Text("Texture Updates: %d\n", state.textureChanges);
+        ImGui::Text("Texture Updates Requested: %d\n", state.textureRequests);
+        ImGui::Text("Texture Updates Performed: %d\n", state.textureChanges);
+        ImGui::Text("Duplicate Updates Skipped: %d\n", state.textureRequests - state.textureChanges);
         ImGui::Text("Cell Updates: %d\n", state.cellChanges);
+        ImGui::Text("Uniform Chunks: %u / %u\n", state.uniformChunks, state.chunkCount);
+        const u32 brushLookups = state.brushCacheHits + state.brushCacheMisses;
+        ImGui::Text("Brush Cache Hit Rate: %.1f%%\n", brushLookups ? 100.0f * state.brushCacheHits / brushLookups : 0.0f);
+        ImGui::Text("Brush Cache: %d Stamps, %.1f KB\n", state.brushCacheStamps, state.brushCacheBytes / 1024.0f);
         ImGui::Text("Mouse X: %d\n", state.mouseX);
         ImGui::Text("Mouse Y: %d\n", state.mouseY);
         ImGui::Text("Mouse Out of Bounds? %d\n", OutofBounds);
@@ -226,6 +435,31 @@ void Interface::debugMenu(AppState& state) { // pair of empty brackets {} define
         ImGui::TreePop();
     }
 
+    if (ImGui::TreeNode("Memory")) {
+        ImGui::SeparatorText("Memory");
+        constexpr f32     MB    = 1024.0f * 1024.0f;
+        const MemoryStats stats = memoryStats();
+        ImGui::Text("Heap: %.2f MB (Peak %.2f MB)\n", stats.totalBytes / MB, stats.totalPeak / MB);
+        ImGui::Text("Allocations / Frame: %llu (Peak %llu, Game Update %llu)\n", static_cast<unsigned long long>(state.frameAllocs),
+                    static_cast<unsigned long long>(state.frameAllocsPeak), static_cast<unsigned long long>(state.updateAllocs));
+        ImGui::Text("Frame Arena: %.1f / %.1f KB (Peak %.1f KB)\n", state.arenaUsed / 1024.0f, state.arenaCapacity / 1024.0f, state.arenaHighWater / 1024.0f);
+        if (ImGui::Button("Reset Peaks")) {
+            resetMemoryPeaks();
+            state.frameAllocsPeak = 0;
+        }
+
+        ImGui::SeparatorText("Live (Peak) MB, Blocks");
+        for (u8 tag = 0; tag < MemoryTag::COUNT; tag++)
+            ImGui::Text("%-14s %8.2f (%8.2f) %8llu\n", MemoryTag::names[tag].data(), stats.liveBytes[tag] / MB, stats.peakBytes[tag] / MB, static_cast<unsigned long long>(stats.liveBlocks[tag]));
+
+        // not heap, the GL textures live in the driver.
+        u64 gpuBytes = 0;
+        for (const TextureData& texture : state.textures) gpuBytes += static_cast<u64>(texture.capacityWidth) * texture.capacityHeight * 4;
+        ImGui::Text("%-14s %8.2f\n", "GL Textures", gpuBytes / MB);
+
+        ImGui::TreePop();
+    }
+
     ImGui::End();
 }
 
@@ -245,19 +479,68 @@ void Interface::gameWindow(AppState& state) {
     if (windowX % 2 != 0) ++windowX;
     if (windowY % 2 != 0) ++windowY;
 
-    if (texture.width + xOffset != windowX || texture.height + yOffset != windowY) {
-        state.reloadGame = true;
-        texture.width    = (int)ImGui::GetWindowSize().x - xOffset;
-        texture.height   = (int)ImGui::GetWindowSize().y - yOffset;
-        if (texture.width % 2 != 0) ++texture.width;   // i don't remember what this does
-        if (texture.height % 2 != 0) ++texture.height; // i don't remember what this does
-        ImGui::SetWindowSize(ImVec2(texture.width, texture.height));
-    } else state.reloadGame = false;
+    // a replay needs the grid it was recorded on, the texture catches up with the window once it's done.
+    // Dragging the edge is coalesced: the world is only resized once the size has held still for resizeSettleMs,
+    // or the mouse has let go. Until then the old texture is stretched over the window.
+    const bool replaying    = state.inputLogMode == InputLogMode::REPLAYING;
+    const int  targetWidth  = windowX - xOffset;
+    const int  targetHeight = windowY - yOffset;
+    bool       resizing     = !replaying && (texture.width != targetWidth || texture.height != targetHeight);
+    state.reloadGame        = false;
+    if (resizing) {
+        if (targetWidth != pendingWidth || targetHeight != pendingHeight) {
+            pendingWidth  = targetWidth;
+            pendingHeight = targetHeight;
+            pendingSince  = ImGui::GetTime();
+        }
+        const bool settled = (ImGui::GetTime() - pendingSince) * 1000 >= state.resizeSettleMs;
+        if (settled || !ImGui::IsMouseDown(ImGuiMouseButton_Left)) {
+            state.reloadGame = true;
+            texture.width    = targetWidth;
+            texture.height   = targetHeight;
+            resizing         = false;
+            ImGui::SetWindowSize(ImVec2(texture.width, texture.height));
+        }
+    }
 
     {
         ImGui::BeginChild("GameRender");
-        ImVec2 textureRenderSize = ImVec2(texture.width, texture.height);
-        ImGui::Image((ImTextureID)texture.id, textureRenderSize, ImVec2(0.0f, 0.0f), ImVec2(1.0f, 1.0f));
+        ImVec2 textureRenderSize = resizing ? ImVec2(targetWidth, targetHeight) : ImVec2(texture.width, texture.height);
+        ImVec2 textureUV         = ImVec2(1.0f, 1.0f); // the GL texture can be bigger than the part in use
+        if (texture.capacityWidth && texture.capacityHeight) textureUV = ImVec2(f32(texture.width) / texture.capacityWidth, f32(texture.height) / texture.capacityHeight);
+        ImGui::Image((ImTextureID)texture.id, textureRenderSize, ImVec2(0.0f, 0.0f), textureUV);
+
+        // the camera moves in whole cells, Game::update() clamps it to the grid & writes it back.
+        const ImVec2 origin  = ImGui::GetItemRectMin();
+        const f32    stretch = textureRenderSize.x / std::max<u16>(1, texture.width); // while resizing
+        const int    zoom    = state.zoom ? state.zoom : state.scaleFactor;
+        if (ImGui::IsItemHovered() && !resizing) {
+            if (io.KeyCtrl && io.MouseWheel != 0) { // keeps the cell under the mouse where it is
+                const int mouseX  = (int)((io.MousePos.x - origin.x) / stretch);
+                const int mouseY  = (int)((io.MousePos.y - origin.y) / stretch);
+                const int newZoom = std::clamp(zoom + (int)io.MouseWheel, 1, (int)AppState::MAX_ZOOM);
+                state.viewX += (mouseX / zoom) - (mouseX / newZoom);
+                state.viewY += (mouseY / zoom) - (mouseY / newZoom);
+                state.zoom = newZoom;
+            }
+            if (ImGui::IsMouseDragging(ImGuiMouseButton_Middle, 0.0f)) {
+                dragX += io.MouseDelta.x / (zoom * stretch);
+                dragY += io.MouseDelta.y / (zoom * stretch);
+                state.viewX -= (int)dragX;
+                state.viewY -= (int)dragY;
+                dragX -= (int)dragX; // the part of a cell left over waits for the next frame
+                dragY -= (int)dragY;
+            }
+        }
+
+        // brush outline lives on top of the image, not in it.
+        const f32   cellSize  = zoom * stretch; // the zoom the outline was built for
+        const f32   blockSize = std::max(1.0f, cellSize / 2);
+        ImDrawList* drawList  = ImGui::GetWindowDrawList();
+        for (const auto& [x, y] : state.drawIndicators) {
+            const ImVec2 min = ImVec2(origin.x + x * cellSize, origin.y + y * cellSize);
+            drawList->AddRectFilled(min, ImVec2(min.x + blockSize, min.y + blockSize), IM_COL32_WHITE);
+        }
         ImGui::EndChild();
     }
     ImGui::End();
@@ -1,9 +1,15 @@
 #pragma once
+#include "benchmark.h"
 #include "framework.h"
+#include "inputlog.h"
 
 Framework *app = nullptr;
 
-int main(int, char **) {
+int main(int argc, char **argv) {
+    // headless modes, never open a window.
+    if (argc > 1 && std::string_view(argv[1]) == "--benchmark") return runBenchmarks(argc > 2 ? argv[2] : "");
+    if (argc > 2 && std::string_view(argv[1]) == "--replay") return runReplay(argv[2]);
+
     const int width  = 1280;
     const int height = 720;
 
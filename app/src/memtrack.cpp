@@ -0,0 +1,119 @@
+#pragma once
+#include "memtrack.h"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+// In front of every block, 16 bytes so the block keeps malloc's alignment.
+struct alignas(16) BlockHeader {
+    u64 bytes;
+    u8  tag;
+};
+
+// The autosave thread allocates too, hence the atomics.
+static std::atomic<u64> liveBytes[MemoryTag::COUNT];
+static std::atomic<u64> liveBlocks[MemoryTag::COUNT];
+static std::atomic<u64> peakBytes[MemoryTag::COUNT];
+static std::atomic<u64> allocations[MemoryTag::COUNT];
+static std::atomic<u64> totalBytes{0};
+static std::atomic<u64> totalPeak{0};
+
+static thread_local u8 currentTag = MemoryTag::OTHER;
+
+static void raisePeak(std::atomic<u64>& peak, u64 value) {
+    u64 seen = peak.load(std::memory_order_relaxed);
+    while (value > seen && !peak.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {}
+}
+
+void* trackedAlloc(size_t bytes, u8 tag) {
+    BlockHeader* header = static_cast<BlockHeader*>(std::malloc(sizeof(BlockHeader) + bytes));
+    if (!header) return nullptr;
+    header->bytes = bytes;
+    header->tag   = tag;
+
+    allocations[tag].fetch_add(1, std::memory_order_relaxed);
+    liveBlocks[tag].fetch_add(1, std::memory_order_relaxed);
+    raisePeak(peakBytes[tag], liveBytes[tag].fetch_add(bytes, std::memory_order_relaxed) + bytes);
+    raisePeak(totalPeak, totalBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+    return header + 1;
+}
+
+void trackedFree(void* ptr) {
+    if (!ptr) return;
+    BlockHeader* header = static_cast<BlockHeader*>(ptr) - 1;
+    liveBlocks[header->tag].fetch_sub(1, std::memory_order_relaxed);
+    liveBytes[header->tag].fetch_sub(header->bytes, std::memory_order_relaxed);
+    totalBytes.fetch_sub(header->bytes, std::memory_order_relaxed);
+    std::free(header);
+}
+
+void adviseHugePages(void* ptr, size_t bytes) {
+#ifdef __linux__
+    constexpr uintptr_t HUGE_PAGE = 2 * 1024 * 1024;
+    const uintptr_t     first     = (reinterpret_cast<uintptr_t>(ptr) + HUGE_PAGE - 1) & ~(HUGE_PAGE - 1); // madvise() wants it aligned
+    const uintptr_t     last      = (reinterpret_cast<uintptr_t>(ptr) + bytes) & ~(HUGE_PAGE - 1);
+    if (first < last) madvise(reinterpret_cast<void*>(first), last - first, MADV_HUGEPAGE);
+#else
+    (void)ptr;
+    (void)bytes;
+#endif
+}
+
+MemoryScope::MemoryScope(u8 tag) : previous(currentTag) { currentTag = tag; }
+MemoryScope::~MemoryScope() { currentTag = previous; }
+
+u64 heapAllocations() {
+    u64 count = 0;
+    for (const auto& tagged : allocations) count += tagged.load(std::memory_order_relaxed);
+    return count;
+}
+
+MemoryStats memoryStats() {
+    MemoryStats stats;
+    for (u8 tag = 0; tag < MemoryTag::COUNT; tag++) {
+        stats.liveBytes[tag]   = liveBytes[tag].load(std::memory_order_relaxed);
+        stats.liveBlocks[tag]  = liveBlocks[tag].load(std::memory_order_relaxed);
+        stats.peakBytes[tag]   = peakBytes[tag].load(std::memory_order_relaxed);
+        stats.allocations[tag] = allocations[tag].load(std::memory_order_relaxed);
+    }
+    stats.totalBytes = totalBytes.load(std::memory_order_relaxed);
+    stats.totalPeak  = totalPeak.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void resetMemoryPeaks() {
+    for (u8 tag = 0; tag < MemoryTag::COUNT; tag++) peakBytes[tag].store(liveBytes[tag].load(std::memory_order_relaxed), std::memory_order_relaxed);
+    totalPeak.store(totalBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+void printMemoryReport() {
+    const MemoryStats stats = memoryStats();
+    printf("%-16s %12s %12s %10s %12s\n", "memory", "live (KB)", "peak (KB)", "blocks", "allocations");
+    for (u8 tag = 0; tag < MemoryTag::COUNT; tag++)
+        printf("%-16s %12.1f %12.1f %10llu %12llu\n", MemoryTag::names[tag].data(), stats.liveBytes[tag] / 1024.0, stats.peakBytes[tag] / 1024.0,
+               static_cast<unsigned long long>(stats.liveBlocks[tag]), static_cast<unsigned long long>(stats.allocations[tag]));
+    printf("%-16s %12.1f %12.1f\n", "total", stats.totalBytes / 1024.0, stats.totalPeak / 1024.0);
+}
+
+/*--------------------------------------------------------------------------------------
+---- Global Operator New ---------------------------------------------------------------
+--------------------------------------------------------------------------------------*/
+
+// the sized & nothrow deletes end up in these by default. Over-aligned types go through the aligned
+// overloads, which stay the standard library's own, they aren't counted.
+void* operator new(size_t bytes) {
+    if (void* ptr = trackedAlloc(bytes, currentTag)) return ptr;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t bytes) { return operator new(bytes); }
+void* operator new(size_t bytes, const std::nothrow_t&) noexcept { return trackedAlloc(bytes, currentTag); }
+void* operator new[](size_t bytes, const std::nothrow_t&) noexcept { return trackedAlloc(bytes, currentTag); }
+
+void operator delete(void* ptr) noexcept { trackedFree(ptr); }
+void operator delete[](void* ptr) noexcept { trackedFree(ptr); }
+void operator delete(void* ptr, size_t) noexcept { trackedFree(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { trackedFree(ptr); }
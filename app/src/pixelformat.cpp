@@ -0,0 +1,93 @@
+#pragma once
+#include "pixelformat.h"
+#include "blit.h"
+#include "simd.h"
+#include <cstring>
+
+/*--------------------------------------------------------------------------------------
+---- Scalar Kernels --------------------------------------------------------------------
+--------------------------------------------------------------------------------------*/
+
+static void rgb24ToRGBA_Scalar(const u8* src, u32 count, u8* dst) {
+    for (u32 i = 0; i < count; i++, src += 3) {
+        const u32 texel = packRGBA(src[0], src[1], src[2], 255);
+        std::memcpy(dst + (i * 4), &texel, sizeof(u32));
+    }
+}
+
+static void argbToRGBA_Scalar(const u32* src, u32 count, u8* dst) {
+    for (u32 i = 0; i < count; i++) {
+        const u32 texel = packRGBA((src[i] >> 16) & 0xFF, (src[i] >> 8) & 0xFF, src[i] & 0xFF, src[i] >> 24);
+        std::memcpy(dst + (i * 4), &texel, sizeof(u32));
+    }
+}
+
+/*--------------------------------------------------------------------------------------
+---- SSSE3 Kernels ---------------------------------------------------------------------
+--------------------------------------------------------------------------------------*/
+
+#ifdef PIXEL_X86
+// 16 pixels a loop: 3 loads of 48 bytes of RGB, realigned so each register starts on a pixel,
+// then one pshufb spreads 4 pixels out to 16 bytes & the alpha gets OR'd in. Never reads past the row.
+TARGET_SSSE3 static void rgb24ToRGBA_SSSE3(const u8* src, u32 count, u8* dst) {
+    const __m128i spread = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    const __m128i alpha  = _mm_set1_epi32(static_cast<int>(0xFF000000));
+
+    u32 i = 0;
+    for (; i + 16 <= count; i += 16, src += 48, dst += 64) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 0));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 16));
+        const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 32));
+
+        const __m128i p0 = a;                         // bytes  0 - 11
+        const __m128i p1 = _mm_alignr_epi8(b, a, 12); // bytes 12 - 23
+        const __m128i p2 = _mm_alignr_epi8(c, b, 8);  // bytes 24 - 35
+        const __m128i p3 = _mm_srli_si128(c, 4);      // bytes 36 - 47
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 0), _mm_or_si128(_mm_shuffle_epi8(p0, spread), alpha));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 16), _mm_or_si128(_mm_shuffle_epi8(p1, spread), alpha));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 32), _mm_or_si128(_mm_shuffle_epi8(p2, spread), alpha));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 48), _mm_or_si128(_mm_shuffle_epi8(p3, spread), alpha));
+    }
+    rgb24ToRGBA_Scalar(src, count - i, dst);
+}
+
+// B, G, R, A --> R, G, B, A, swaps bytes 0 & 2 of every pixel.
+TARGET_SSSE3 static void argbToRGBA_SSSE3(const u32* src, u32 count, u8* dst) {
+    const __m128i swizzle = _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+
+    u32 i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 0));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 4));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + (i * 4) + 0), _mm_shuffle_epi8(a, swizzle));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + (i * 4) + 16), _mm_shuffle_epi8(b, swizzle));
+    }
+    argbToRGBA_Scalar(src + i, count - i, dst + (i * 4));
+}
+#endif
+
+/*--------------------------------------------------------------------------------------
+---- Dispatch --------------------------------------------------------------------------
+--------------------------------------------------------------------------------------*/
+
+struct PixelFormatKernels {
+    std::string_view name;
+    void (*rgb24)(const u8* src, u32 count, u8* dst);
+    void (*argb)(const u32* src, u32 count, u8* dst);
+};
+
+static const PixelFormatKernels& pixelFormatKernels() {
+    static const PixelFormatKernels kernels = []() -> PixelFormatKernels {
+#ifdef PIXEL_X86
+        if (cpuFeatures().ssse3) return {"SSSE3", rgb24ToRGBA_SSSE3, argbToRGBA_SSSE3};
+#endif
+        return {"Scalar", rgb24ToRGBA_Scalar, argbToRGBA_Scalar};
+    }();
+    return kernels;
+}
+
+std::string_view pixelFormatKernelName() { return pixelFormatKernels().name; }
+
+void rgb24ToRGBA(const u8* src, u32 count, u8* dst) { pixelFormatKernels().rgb24(src, count, dst); }
+void argbToRGBA(const u32* src, u32 count, u8* dst) { pixelFormatKernels().argb(src, count, dst); }
@@ -0,0 +1,110 @@
+#pragma once
+#include "rewind.h"
+#include "snapshot.h"
+
+void RewindBuffer::resize(u16 newWidth, u16 newHeight, u8 newVariants) {
+    MemoryScope tag(MemoryTag::CHANGE_LISTS);
+    width     = newWidth;
+    height    = newHeight;
+    nVariants = newVariants;
+    touched.assign(((static_cast<size_t>(width) * height) + 63) / 64, 0);
+    pending.clear();
+    clear(0, 0);
+}
+
+void RewindBuffer::clear(u32 frame, u64 seed) {
+    for (const CellChange& change : pending) touched[change.idx >> 6] = 0;
+    pending.clear();
+    changes.clear();
+    steps.clear();
+    keyframes.clear();
+    bytes         = 0;
+    base          = 0;
+    cursor        = 0;
+    firstChange   = 0;
+    sinceKeyframe = 0;
+    baseFrame     = frame;
+    baseSeed      = seed;
+}
+
+void RewindBuffer::setBudget(u64 newBudget, u32 frame, u64 seed) {
+    if (newBudget == budget) return;
+    if (budget == 0 || newBudget == 0) clear(frame, seed); // nothing was (or will be) recorded, the history is stale either way.
+    budget = newBudget;
+    evict();
+}
+
+void RewindBuffer::commit(const Cell* cells, u32 frame, u64 seed) {
+    if (!recording()) return;
+    if (pending.empty() && frame == frameAt(cursor)) return; // paused & nothing drawn, not worth a step.
+    MemoryScope tag(MemoryTag::CHANGE_LISTS);
+    truncate();
+
+    // settled sand swaps with itself every frame, those writes didn't change anything & would fill the budget.
+    size_t kept = 0;
+    for (CellChange& change : pending) {
+        change.after             = cells[change.idx];
+        change.after.updated     = false;
+        change.before.updated    = false;
+        touched[change.idx >> 6] = 0;
+        if (change.before.matID != change.after.matID || change.before.variant != change.after.variant || change.before.data != change.after.data) pending[kept++] = change;
+    }
+    pending.resize(kept);
+    steps.push_back({firstChange + changes.size(), static_cast<u32>(pending.size()), frame, seed});
+    changes.insert(changes.end(), pending.begin(), pending.end());
+    bytes += sizeof(Step) + (pending.size() * sizeof(CellChange));
+    sinceKeyframe += pending.size();
+    pending.clear();
+    cursor = newest();
+
+    // once replaying back to the last keyframe costs more than decoding one, take another.
+    if (sinceKeyframe > static_cast<u64>(width) * height / 4) takeKeyframe(cells);
+    evict();
+}
+
+void RewindBuffer::takeKeyframe(const Cell* cells) {
+    Keyframe& keyframe = keyframes.emplace_back();
+    keyframe.position  = cursor;
+    keyframe.frame     = frameAt(cursor);
+    keyframe.seed      = seedAt(cursor);
+    encodeCells(cells, width, height, nVariants, keyframe.cells);
+    bytes += keyframe.cells.size();
+    sinceKeyframe = 0;
+}
+
+void RewindBuffer::restoreKeyframe(const Keyframe& keyframe, Cell* cells) {
+    decodeCells(keyframe.cells, cells, width, height, nVariants);
+}
+
+void RewindBuffer::truncate() {
+    while (!keyframes.empty() && keyframes.back().position > cursor) {
+        bytes -= keyframes.back().cells.size();
+        keyframes.pop_back();
+    }
+    while (newest() > cursor) {
+        const Step& step = steps.back();
+        changes.resize(changes.size() - step.changeCount);
+        bytes -= sizeof(Step) + (step.changeCount * sizeof(CellChange));
+        steps.pop_back();
+    }
+    sinceKeyframe = changeIdx(cursor) - changeIdx(keyframes.empty() ? base : keyframes.back().position);
+}
+
+void RewindBuffer::evict() {
+    // never past the cursor, the world has to stay somewhere in the history.
+    while (bytes > budget && base < cursor) {
+        const Step& step = steps.front();
+        changes.erase(changes.begin(), changes.begin() + step.changeCount);
+        bytes -= sizeof(Step) + (step.changeCount * sizeof(CellChange));
+        firstChange += step.changeCount;
+        baseFrame = step.frame;
+        baseSeed  = step.seed;
+        base++;
+        steps.pop_front();
+
+        while (!keyframes.empty() && keyframes.front().position < base) {
+            bytes -= keyframes.front().cells.size();
+            keyframes.pop_front();
+        }
+    }
+}
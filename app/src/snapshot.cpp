@@ -0,0 +1,520 @@
+#pragma once
+#include "snapshot.h"
+#include "game.h"
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/*--------------------------------------------------------------------------------------
+---- Mapped Files ----------------------------------------------------------------------
+--------------------------------------------------------------------------------------*/
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this == &other) return *this;
+    close();
+    base     = std::exchange(other.base, nullptr);
+    bytes    = std::exchange(other.bytes, 0);
+    filePath = std::move(other.filePath);
+#ifdef _WIN32
+    file    = std::exchange(other.file, nullptr);
+    mapping = std::exchange(other.mapping, nullptr);
+#endif
+    return *this;
+}
+
+#ifdef _WIN32
+bool MappedFile::open(const std::string& path) {
+    close();
+    HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) return false;
+    file = handle;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(handle, &fileSize) || fileSize.QuadPart == 0) {
+        close();
+        return false;
+    }
+
+    // PAGE_WRITECOPY + FILE_MAP_COPY == copy-on-write, same as MAP_PRIVATE.
+    mapping = CreateFileMappingA(handle, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+    if (!mapping) {
+        close();
+        return false;
+    }
+    base = static_cast<u8*>(MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0));
+    if (!base) {
+        close();
+        return false;
+    }
+    bytes    = static_cast<size_t>(fileSize.QuadPart);
+    filePath = path;
+    return true;
+}
+
+void MappedFile::close() {
+    if (base) UnmapViewOfFile(base);
+    if (mapping) CloseHandle(mapping);
+    if (file) CloseHandle(file);
+    base    = nullptr;
+    mapping = nullptr;
+    file    = nullptr;
+    bytes   = 0;
+    filePath.clear();
+}
+#else
+bool MappedFile::open(const std::string& path) {
+    close();
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+
+    void* mapped = mmap(nullptr, info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    ::close(fd); // the mapping keeps its own reference to the file.
+    if (mapped == MAP_FAILED) return false;
+
+    base     = static_cast<u8*>(mapped);
+    bytes    = info.st_size;
+    filePath = path;
+    return true;
+}
+
+void MappedFile::close() {
+    if (base) munmap(base, bytes);
+    base  = nullptr;
+    bytes = 0;
+    filePath.clear();
+}
+#endif
+
+/*--------------------------------------------------------------------------------------
+---- RLE Encoding ----------------------------------------------------------------------
+--------------------------------------------------------------------------------------*/
+
+static constexpr u8     ROW_REPEAT  = 1 << 0; // matIDs are the same as the row above
+static constexpr u8     ROW_NO_DATA = 1 << 1; // every data byte is 0
+static constexpr size_t FLUSH_BYTES = 1024 * 1024;
+
+// (value, length) runs of one byte of each cell, field() picks the byte.
+template <typename Field>
+static void putRuns(const Cell* row, u16 width, std::vector<u8>& out, Field&& field) {
+    for (u32 x = 0; x < width;) {
+        const u8 value = field(row[x]);
+        u32      end   = x + 1;
+        while (end < width && field(row[end]) == value) end++;
+        out.push_back(value);
+        putVarint(out, end - x);
+        x = end;
+    }
+}
+
+// runs must cover the row exactly & every value must be below 'limit', anything else is a corrupt file.
+// with row == nullptr the runs are only checked.
+static bool getRuns(const u8*& p, const u8* end, u8* row, u16 width, u32 limit) {
+    for (u32 x = 0; x < width;) {
+        u32 length = 0;
+        if (p >= end) return false;
+        const u8 value = *p++;
+        if (value >= limit || !getVarint(p, end, length) || length == 0 || length > width - x) return false;
+        if (row) std::memset(row + x, value, length);
+        x += length;
+    }
+    return true;
+}
+
+// appends one row's record to 'out', see snapshot.h for the layout. 'above' is nullptr for the first row.
+static void encodeRow(const Cell* row, const Cell* above, u16 width, u8 variantBits, std::vector<u8>& out) {
+    const bool repeat = above && std::equal(row, row + width, above, [](const Cell& a, const Cell& b) -> bool { return a.matID == b.matID; });
+    const bool noData = std::all_of(row, row + width, [](const Cell& c) -> bool { return c.data == 0; });
+
+    out.push_back((repeat ? ROW_REPEAT : 0) | (noData ? ROW_NO_DATA : 0));
+    if (!repeat) putRuns(row, width, out, [](const Cell& c) -> u8 { return c.matID; });
+
+    // variants are random per cell, nothing to run-length, so just drop the unused high bits.
+    const size_t variantBytes = ((static_cast<size_t>(width) * variantBits) + 7) / 8;
+    const size_t at           = out.size();
+    out.resize(at + variantBytes + 4); // + 4, the last flush writes a whole word.
+    u8* dst   = &out[at];
+    u64 bits  = 0;
+    u32 nBits = 0;
+    for (u16 x = 0; x < width; x++) {
+        bits |= static_cast<u64>(row[x].variant) << nBits;
+        nBits += variantBits;
+        if (nBits >= 32) {
+            std::memcpy(dst, &bits, 4); // little endian, like the rest of the file.
+            dst += 4;
+            bits >>= 32;
+            nBits -= 32;
+        }
+    }
+    std::memcpy(dst, &bits, 4);
+    out.resize(at + variantBytes);
+
+    if (!noData) putRuns(row, width, out, [](const Cell& c) -> u8 { return c.data; });
+}
+
+// Decodes one row record into 'row', or with row == nullptr just checks it, returns false if it's malformed.
+// matIDs & data are scratch rows, matIDs still holds the row above so a repeated row costs nothing
+// (a repeat on the first row just repeats the zeroed scratch, EMPTY).
+static bool decodeRow(const u8*& p, const u8* end, Cell* row, u8* matIDs, u8* data, u16 width, u8 variantBits, u8 nMaterials, u8 nVariants) {
+    if (p >= end) return false;
+    const u8 flags = *p++;
+    if (!(flags & ROW_REPEAT) && !getRuns(p, end, row ? matIDs : nullptr, width, nMaterials)) return false;
+
+    const size_t variantBytes = ((static_cast<size_t>(width) * variantBits) + 7) / 8;
+    if (static_cast<size_t>(end - p) < variantBytes) return false;
+    const u8* variants = p;
+    p += variantBytes;
+
+    if (flags & ROW_NO_DATA) {
+        if (row) std::memset(data, 0, width);
+    } else if (!getRuns(p, end, row ? data : nullptr, width, 256)) return false;
+    if (!row) return true;
+
+    // everything for the row is in hand, so each cell is built & stored in one go.
+    // a bad variant is clamped rather than checked, it can only ever be the wrong shade.
+    const u8* variantEnd = variants + variantBytes;
+    const u64 mask       = (u64(1) << variantBits) - 1;
+    const u8  maxVariant = nVariants - 1;
+    u64       bits       = 0;
+    u32       nBits      = 0;
+    for (u16 x = 0; x < width; x++) {
+        if (nBits < variantBits) { // refill 32 bits at a time, the last refill of the row may be short.
+            u32 word = 0;
+            if (variantEnd - variants >= 4) std::memcpy(&word, variants, 4);
+            else
+                for (u32 i = 0; variants + i < variantEnd; i++) word |= static_cast<u32>(variants[i]) << (8 * i);
+            variants += std::min<std::ptrdiff_t>(4, variantEnd - variants);
+            bits |= static_cast<u64>(word) << nBits;
+            nBits += 32;
+        }
+        row[x] = Cell(false, matIDs[x], std::min<u8>(bits & mask, maxVariant), data[x]);
+        bits >>= variantBits;
+        nBits -= variantBits;
+    }
+    return true;
+}
+
+void encodeCells(const Cell* cells, u16 width, u16 height, u8 nVariants, std::vector<u8>& out) {
+    const u8 variantBits = std::bit_width(static_cast<u32>(nVariants - 1));
+    out.clear();
+    for (u16 y = 0; y < height; y++) {
+        const Cell* row = cells + (static_cast<size_t>(y) * width);
+        encodeRow(row, y > 0 ? row - width : nullptr, width, variantBits, out);
+    }
+    out.shrink_to_fit(); // these are kept around, don't hang on to the growth slack.
+}
+
+void decodeCells(const std::vector<u8>& plane, Cell* cells, u16 width, u16 height, u8 nVariants) {
+    const u8        variantBits = std::bit_width(static_cast<u32>(nVariants - 1));
+    std::vector<u8> matIDs(width), data(width);
+    const u8*       p   = plane.data();
+    const u8*       end = plane.data() + plane.size();
+    for (u16 y = 0; y < height; y++) decodeRow(p, end, cells + (static_cast<size_t>(y) * width), matIDs.data(), data.data(), width, variantBits, 255, nVariants);
+}
+
+/*--------------------------------------------------------------------------------------
+---- Saving & Loading ------------------------------------------------------------------
+--------------------------------------------------------------------------------------*/
+
+// below this a save is just copied out of the mapping, not worth keeping a file open for.
+static constexpr size_t ADOPT_THRESHOLD = 1024 * 1024;
+
+// FNV-1a over everything that changes what a matID means.
+u64 Game::materialHash() const {
+    u64  hash = 0xCBF29CE484222325;
+    auto mix  = [&](u64 value) -> void {
+        hash ^= value;
+        hash *= 0x100000001B3;
+    };
+    mix(materials.size());
+    mix(nVariants);
+    for (const Material& mat : materials) {
+        mix(mat.r);
+        mix(mat.g);
+        mix(mat.b);
+        mix(mat.a);
+        mix(mat.dispersion);
+        mix(mat.density);
+        mix(mat.movable);
+    }
+    return hash;
+}
+
+// Streams the header, then the cells, then the chunks. RAW writes straight out of 'cells', no intermediate copy,
+// RLE encodes a row at a time into a small buffer that's flushed as it fills. The chunks come encoded already.
+// Written to a temp file & renamed over 'path', so a crash mid-save never leaves half a world behind.
+bool writeSnapshot(const std::string& path, SnapshotHeader header, const Cell* cells, const std::vector<StoredChunk>& chunks) {
+    const std::string temp = path + ".tmp";
+    std::ofstream     file(temp, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        std::cout << "Unable to save snapshot " << path << '\n';
+        return false;
+    }
+
+    const size_t count = static_cast<size_t>(header.cellWidth) * header.cellHeight;
+    header.chunkBytes  = 0;
+    for (const StoredChunk& chunk : chunks) header.chunkBytes += StoredChunk::RECORD_BYTES + chunk.cells.size();
+    if (header.encoding == SnapshotEncoding::RLE) {
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header)); // planeBytes isn't known yet, rewritten after the chunks.
+
+        const u8        variantBits = std::bit_width(static_cast<u32>(header.nVariants - 1));
+        std::vector<u8> buffer;
+        buffer.reserve(FLUSH_BYTES + (header.cellWidth * 8));
+        for (u16 y = 0; y < header.cellHeight; y++) {
+            const Cell* row = cells + (static_cast<size_t>(y) * header.cellWidth);
+            encodeRow(row, y > 0 ? row - header.cellWidth : nullptr, header.cellWidth, variantBits, buffer);
+            if (buffer.size() >= FLUSH_BYTES || y == header.cellHeight - 1) {
+                file.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+                header.planeBytes += buffer.size();
+                buffer.clear();
+            }
+        }
+    } else {
+        header.planeBytes = count * sizeof(Cell);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(cells), header.planeBytes);
+    }
+    for (const StoredChunk& chunk : chunks) {
+        const u32 length = chunk.cells.size();
+        file.write(reinterpret_cast<const char*>(&chunk.cx), sizeof(chunk.cx));
+        file.write(reinterpret_cast<const char*>(&chunk.cy), sizeof(chunk.cy));
+        file.write(reinterpret_cast<const char*>(&chunk.flags), sizeof(chunk.flags));
+        file.write(reinterpret_cast<const char*>(&chunk.material), sizeof(chunk.material));
+        file.write(reinterpret_cast<const char*>(&length), sizeof(length));
+        file.write(reinterpret_cast<const char*>(chunk.cells.data()), length);
+    }
+    if (header.encoding == SnapshotEncoding::RLE) {
+        file.seekp(0);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    }
+    file.close();
+
+    std::error_code error;
+    if (!file.fail()) std::filesystem::rename(temp, path, error);
+    if (file.fail() || error) {
+        std::cout << "Unable to save snapshot " << path << '\n';
+        std::filesystem::remove(temp, error);
+        return false;
+    }
+    return true;
+}
+
+SnapshotHeader Game::snapshotHeader(u32 frame, u8 encoding) const {
+    SnapshotHeader header;
+    header.cellWidth    = cellWidth;
+    header.cellHeight   = cellHeight;
+    header.scaleFactor  = scaleFactor;
+    header.cellBytes    = sizeof(Cell);
+    header.nMaterials   = materials.size();
+    header.nVariants    = nVariants;
+    header.encoding     = encoding;
+    header.frame        = frame;
+    header.seed         = seed;
+    header.materialHash = materialHash();
+    header.worldX       = worldX;
+    header.worldY       = worldY;
+    return header;
+}
+
+// waits for the chunks that have to be read back from the chunk store file, see ChunkStore::collect().
+bool Game::saveSnapshot(const std::string& path, u32 frame, u8 encoding) {
+    releaseMapping(path);
+    std::vector<StoredChunk> stored = world.collect(nVariants).get();
+    for (StoredChunk& chunk : stored)
+        if (std::ranges::find(arriving, std::pair(chunk.cx, chunk.cy)) != arriving.end()) chunk.flags |= StoredChunk::ARRIVING;
+    return writeSnapshot(path, snapshotHeader(frame, encoding), cells.data(), stored);
+}
+
+// the cells might be mapped from a file that's about to be replaced, windows won't rename over
+// a mapped file so copy them out first.
+void Game::releaseMapping(const std::string& path) {
+    std::error_code error;
+    if (cells.isMapped() && std::filesystem::equivalent(cells.mappedPath(), path, error)) cells.detach();
+}
+
+// Large RAW saves are adopted as the cell storage in place, smaller ones (or a grid that doesn't match
+// the current window) are copied. RLE saves are decoded into fresh storage.
+// The grid size comes from the window, so a save from a different size / scaleFactor goes into the chunk store
+// with the rest of the world & the window's copied back out of it, same as reload() does.
+// Whatever was streamed before is forgotten, the save's world replaces all of it.
+bool Game::loadSnapshot(const std::string& path, u32& frame) {
+    MappedFile file;
+    if (!file.open(path) || file.size() < sizeof(SnapshotHeader)) {
+        std::cout << "Unable to load snapshot " << path << '\n';
+        return false;
+    }
+
+    SnapshotHeader header;
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (header.version < 3) { // was padding
+        header.worldX     = 0;
+        header.worldY     = 0;
+        header.chunkBytes = 0;
+    }
+    const size_t count = static_cast<size_t>(header.cellWidth) * header.cellHeight;
+    const char*  error = nullptr;
+    if (header.magic != SnapshotHeader::MAGIC) error = "not a snapshot";
+    else if (header.version == 0 || header.version > SnapshotHeader::VERSION) error = "unsupported version";
+    else if (header.encoding >= SnapshotEncoding::COUNT) error = "unsupported encoding";
+    else if (header.cellBytes != sizeof(Cell)) error = "different cell layout";
+    else if (header.nMaterials != materials.size() || header.nVariants != nVariants || header.materialHash != materialHash()) error = "different material table";
+    else if (header.headerBytes < sizeof(SnapshotHeader) || header.headerBytes > file.size() || header.planeBytes > file.size() - header.headerBytes) error = "truncated"; // planeBytes can't be trusted to add
+    else if (header.chunkBytes > file.size() - header.headerBytes - header.planeBytes) error = "truncated";
+    else if (header.encoding == SnapshotEncoding::RAW && header.planeBytes != count * sizeof(Cell)) error = "truncated";
+
+    const u8* plane       = file.data() + header.headerBytes;
+    const u8* end         = plane + header.planeBytes;
+    const u8  variantBits = std::bit_width(static_cast<u32>(nVariants - 1));
+    if (!error && header.encoding == SnapshotEncoding::RLE) {
+        // check every record before touching the world, a corrupt file shouldn't leave it half loaded.
+        const u8* p = plane;
+        for (u16 y = 0; y < header.cellHeight && !error; y++)
+            if (!decodeRow(p, end, nullptr, nullptr, nullptr, header.cellWidth, variantBits, header.nMaterials, nVariants)) error = "corrupt cells";
+    } else if (!error) {
+        // a bad matID or variant would index straight off the end of the palette.
+        const Cell* raw = reinterpret_cast<const Cell*>(plane);
+        if (std::any_of(raw, raw + count, [&](const Cell& c) -> bool { return c.matID >= materials.size() || c.variant >= nVariants; })) error = "corrupt cells";
+    }
+
+    // same for the chunk records, the cells are decoded into the store once they're all known to be good.
+    struct Record {
+        s32       cx, cy;
+        u8        flags, material;
+        const u8 *begin, *end;
+    };
+    std::vector<Record> records;
+    for (const u8 *p = end, *chunksEnd = end + header.chunkBytes; p < chunksEnd && !error;) {
+        Record record;
+        u32    length;
+        if (static_cast<u64>(chunksEnd - p) < StoredChunk::RECORD_BYTES) {
+            error = "corrupt chunks";
+            break;
+        }
+        std::memcpy(&record.cx, p, 4);
+        std::memcpy(&record.cy, p + 4, 4);
+        record.flags    = p[8];
+        record.material = p[9];
+        std::memcpy(&length, p + 10, 4);
+        p += StoredChunk::RECORD_BYTES;
+        if (length > static_cast<u64>(chunksEnd - p)) error = "corrupt chunks";
+        else if (record.flags & StoredChunk::UNIFORM) {
+            if (length != 0 || record.material >= header.nMaterials) error = "corrupt chunks";
+        } else {
+            const u8* q = p;
+            for (u16 y = 0; y < ChunkStore::CHUNK_SIZE && !error; y++)
+                if (!decodeRow(q, p + length, nullptr, nullptr, nullptr, ChunkStore::CHUNK_SIZE, variantBits, header.nMaterials, nVariants)) error = "corrupt chunks";
+            if (q != p + length) error = "corrupt chunks";
+        }
+        record.begin = p;
+        record.end   = p + length;
+        p += length;
+        records.push_back(record);
+    }
+    if (error) {
+        std::cout << "Unable to load snapshot " << path << ": " << error << '\n';
+        return false;
+    }
+
+    auto decodeInto = [&](Cell* dst) -> void {
+        std::vector<u8> matIDs(header.cellWidth), data(header.cellWidth);
+        const u8*       p = plane;
+        for (u16 y = 0; y < header.cellHeight; y++) decodeRow(p, end, dst + (static_cast<size_t>(y) * header.cellWidth), matIDs.data(), data.data(), header.cellWidth, variantBits, header.nMaterials, nVariants);
+    };
+
+    world.clear();
+    arriving.clear();
+    worldX = panX = header.worldX;
+    worldY = panY = header.worldY;
+    {
+        std::vector<u8> matIDs(ChunkStore::CHUNK_SIZE), data(ChunkStore::CHUNK_SIZE);
+        for (const Record& record : records) {
+            if (record.flags & StoredChunk::UNIFORM) {
+                world.storeUniform(record.cx, record.cy, record.material);
+                continue;
+            }
+            bool      created;
+            Cell*     chunk = world.store(record.cx, record.cy, created);
+            const u8* p     = record.begin;
+            for (u16 y = 0; y < ChunkStore::CHUNK_SIZE; y++) decodeRow(p, record.end, chunk + (y * ChunkStore::CHUNK_SIZE), matIDs.data(), data.data(), ChunkStore::CHUNK_SIZE, variantBits, header.nMaterials, nVariants);
+        }
+    }
+
+    if (header.cellWidth == cellWidth && header.cellHeight == cellHeight) {
+        if (header.encoding == SnapshotEncoding::RLE) {
+            if (cells.isMapped() || cells.size() != count) cells.resize(count); // otherwise decode over the old world, no page faulting in a fresh 30 MB.
+            decodeInto(cells.data());
+        } else if (file.size() >= ADOPT_THRESHOLD) cells.adopt(std::move(file), header.headerBytes, count);
+        else {
+            cells.resize(count);
+            std::memcpy(cells.data(), plane, header.planeBytes);
+        }
+        // the store's back how it was when it was saved, pinned where the window only has part of a chunk.
+        for (const Record& record : records) {
+            const u16 w = visibleCells(record.cx, worldX, cellWidth), h = visibleCells(record.cy, worldY, cellHeight);
+            if (!w || !h) continue;
+            if (record.flags & StoredChunk::ARRIVING) copyChunk(record.cx, record.cy);
+            else if (w < ChunkStore::CHUNK_SIZE || h < ChunkStore::CHUNK_SIZE) world.pin(record.cx, record.cy, true);
+            else world.release(record.cx, record.cy); // the grid has all of it
+        }
+    } else {
+        CellBuffer decoded;
+        if (header.encoding == SnapshotEncoding::RLE) {
+            decoded.resize(count);
+            decodeInto(decoded.data());
+        }
+        const Cell* saved = header.encoding == SnapshotEncoding::RLE ? decoded.data() : reinterpret_cast<const Cell*>(plane);
+
+        // the saved window goes into the store like a resize would put it there, then the new one's copied out.
+        const u16 savedCols = (header.cellWidth + ChunkStore::CHUNK_SIZE - 1) / ChunkStore::CHUNK_SIZE;
+        const u16 savedRows = (header.cellHeight + ChunkStore::CHUNK_SIZE - 1) / ChunkStore::CHUNK_SIZE;
+        std::vector<std::pair<s32, s32>> placeholders;
+        for (const Record& record : records)
+            if (record.flags & StoredChunk::ARRIVING) placeholders.emplace_back(record.cx, record.cy);
+        for (u16 row = 0; row < savedRows; row++)
+            for (u16 col = 0; col < savedCols; col++) {
+                const s32 cx = worldX + col, cy = worldY + row;
+                if (std::ranges::find(placeholders, std::pair(cx, cy)) != placeholders.end()) continue; // the record has the real thing
+                const Cell* src = saved + (static_cast<size_t>(row) * ChunkStore::CHUNK_SIZE * header.cellWidth) + (col * ChunkStore::CHUNK_SIZE);
+                storeChunk(cx, cy, src, header.cellWidth, visibleCells(cx, worldX, header.cellWidth), visibleCells(cy, worldY, header.cellHeight));
+            }
+        decoded = CellBuffer();
+
+        cells.resize(static_cast<size_t>(cellWidth) * cellHeight);
+        fillEmpty(cells.data(), cells.size());
+        const u16 cols = (cellWidth + ChunkStore::CHUNK_SIZE - 1) / ChunkStore::CHUNK_SIZE;
+        const u16 rows = (cellHeight + ChunkStore::CHUNK_SIZE - 1) / ChunkStore::CHUNK_SIZE;
+        for (u16 row = 0; row < rows; row++)
+            for (u16 col = 0; col < cols; col++)
+                if (world.known(worldX + col, worldY + row)) copyChunk(worldX + col, worldY + row);
+    }
+
+    seed  = header.seed;
+    frame = header.frame;
+    textureChanges.clear();
+    strokeCoverage.clear();
+    strokeActive = false;
+    sizeChanged  = true;
+    rewindStale  = true;
+    return true;
+}